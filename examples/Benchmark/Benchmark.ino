@@ -0,0 +1,266 @@
+/*
+ * Benchmark.ino - measures how fast nextion_ez talks to a display
+ * All rights reserved under the library's licence
+ */
+
+// Compatible for boards with a second Hardware Serial (Arduino Mega, ESP32...)
+
+/* Connect a Nextion display, or a second board running the NextionEmulator example, to Serial1.
+ * The results are printed on the USB Serial as CSV lines, easy to keep and compare between releases:
+ *
+ *   test,baud,value,unit
+ *   writeNum,9600,85.3,cmd/s
+ *   writeNum,9600,11.2,bytes/cmd
+ *   ...
+ *
+ * For each baud rate of BAUD_RATES it measures:
+ *   - commands per second and bytes on the wire per command for writeNum(), writeStr(), sendCmd() and addWave()
+ *   - values per second of streamWave() (set NEXTION_EZ_WAVE_CHANNELS in nextion_ez.h, with 0 it measures addWave())
+ *   - the round trip time of readNum(), p50 and p99 of READS reads
+ *   - the time listen() needs for each received byte, while the display sends events
+ *     (set EVENT_TIME in the emulator to get events)
+ * and once, with baud 0, the time to build a command of writeNum(), writeInt() and writeFixed(),
+ * without the Serial, next to the time Print needs to format the same numbers.
+ *
+ * The display must answer "get n0.val", so a page with a number n0 is needed on a real Nextion.
+ */
+
+#include "nextion_ez.h"
+
+class CountingStream : public Stream {  // passes everything to the Serial and counts the bytes written
+  public:
+    CountingStream(Stream& serial) : bytes(0), _serial(serial) {}
+    unsigned long bytes;
+    int available() { return _serial.available(); }
+    int read() { return _serial.read(); }
+    int peek() { return _serial.peek(); }
+    void flush() { _serial.flush(); }
+    int availableForWrite() { return _serial.availableForWrite(); }
+    size_t write(uint8_t c) {
+      size_t written = _serial.write(c);
+      bytes += written;
+      return written;
+    }
+    size_t write(const uint8_t* data, size_t length) {
+      size_t written = _serial.write(data, length);
+      bytes += written;
+      return written;
+    }
+  private:
+    Stream& _serial;
+};
+
+CountingStream countLink(Serial1);
+nextion_ez myNex(countLink);          // a Stream, so the sketch starts Serial1 itself
+
+#define REPORT Serial
+
+const unsigned long BAUD_RATES[] = {9600, 115200, 921600};
+#define COMMANDS 200                  // commands sent for each write test
+#define READS 100                     // readNum() calls for the latency test
+#define LISTEN_TIME 2000              // ms to measure listen()
+
+#define ENCODES 1000                  // calls for each encoding test
+
+unsigned long latency[READS];
+
+class NullStream : public Stream {    // forgets what is written, so only the time of the library is measured
+  public:
+    int available() { return 0; }
+    int read() { return -1; }
+    int peek() { return -1; }
+    size_t write(uint8_t) { return 1; }
+    size_t write(const uint8_t*, size_t length) { return length; }
+};
+
+NullStream nullLink;
+nextion_ez encodeNex(nullLink);
+
+void setup() {
+  REPORT.begin(115200);
+  Serial1.begin(9600);
+  myNex.begin(9600);
+  delay(500);
+
+  REPORT.println("test,baud,value,unit");
+  runEncoding();
+
+  unsigned long baud = 9600;
+  for (uint8_t i = 0; i < sizeof(BAUD_RATES) / sizeof(BAUD_RATES[0]); i++) {
+    if (BAUD_RATES[i] != baud) {
+      changeBaud(BAUD_RATES[i]);
+      baud = BAUD_RATES[i];
+    }
+    runTests(baud);
+  }
+
+  changeBaud(9600);                   // leave the display as we found it
+  REPORT.println("done");
+}
+
+void loop() {
+}
+
+void changeBaud(unsigned long baud) {
+  myNex.pushCmdArg(baud);
+  myNex.sendCmd("baud=");
+  Serial1.flush();
+  delay(100);
+  Serial1.begin(baud);
+  myNex.begin(baud);
+}
+
+void runTests(unsigned long baud) {
+  unsigned long start;
+
+  start = startWrite();
+  for (uint16_t i = 0; i < COMMANDS; i++) {
+    myNex.writeNum("n0.val", i);
+  }
+  printWrite("writeNum", baud, start);
+
+  start = startWrite();
+  for (uint16_t i = 0; i < COMMANDS; i++) {
+    myNex.writeStr("t0.txt", "Hello World");
+  }
+  printWrite("writeStr", baud, start);
+
+  start = startWrite();
+  for (uint16_t i = 0; i < COMMANDS; i++) {
+    myNex.sendCmd("ref 0");
+  }
+  printWrite("sendCmd", baud, start);
+
+  start = startWrite();
+  for (uint16_t i = 0; i < COMMANDS; i++) {
+    myNex.addWave(1, 0, i);
+  }
+  printWrite("addWave", baud, start);
+
+  start = micros();
+  uint16_t sent = 0;
+  while (sent < COMMANDS * 8) {       // streamWave() is sent by listen(), so call it in the loop
+    if (myNex.streamWave(1, 0, sent)) {
+      sent++;
+    }
+    myNex.listen();
+  }
+  Serial1.flush();                    // the buffer is paced by the link, so this is the steady rate
+  printValue("streamWave", baud, (float)sent * 1000000.0 / (micros() - start), "values/s");
+  myNex.sendWave();                   // the rest of the values
+
+  drain();
+  myNex.writeNum("n0.val", 12345);
+  for (uint8_t i = 0; i < READS; i++) {
+    start = micros();
+    myNex.readNum("n0.val");
+    latency[i] = micros() - start;
+  }
+  sortLatency();
+  printValue("readNum_p50", baud, latency[READS / 2] / 1000.0, "ms");
+  printValue("readNum_p99", baud, latency[(READS * 99) / 100] / 1000.0, "ms");
+
+  unsigned long busy = 0;
+  unsigned long bytes = 0;
+  unsigned long calls = 0;
+  unsigned long worst = 0;
+  start = millis();
+  while ((millis() - start) < LISTEN_TIME) {
+    int before = Serial1.available();
+    unsigned long t = micros();
+    myNex.listen();
+    t = micros() - t;
+    int after = Serial1.available();
+    busy += t;
+    if (t > worst) worst = t;
+    if (before > after) bytes += before - after;
+    calls++;
+    while (myNex.cmdAvail()) {        // take the events, as a sketch would
+      myNex.getCmd();
+    }
+  }
+  printValue("listen_us_per_byte", baud, bytes > 0 ? (float)busy / bytes : 0, "us");
+  printValue("listen_us_per_call", baud, (float)busy / calls, "us");
+  printValue("listen_worst", baud, worst, "us");
+  printValue("listen_bytes", baud, bytes, "bytes");
+}
+
+void runEncoding() {
+  unsigned long start;
+  encodeNex.begin();
+
+  start = micros();
+  for (uint16_t i = 0; i < ENCODES; i++) {
+    encodeNex.writeNum("n0.val", 4000000000UL + i);
+  }
+  printValue("encode_writeNum", 0, (float)(micros() - start) / ENCODES, "us");
+
+  start = micros();
+  for (uint16_t i = 0; i < ENCODES; i++) {
+    encodeNex.writeInt("n0.val", -2000000000L + i);
+  }
+  printValue("encode_writeInt", 0, (float)(micros() - start) / ENCODES, "us");
+
+  start = micros();
+  for (uint16_t i = 0; i < ENCODES; i++) {
+    encodeNex.writeFixed("x0.val", -123.45 + i, 2);
+  }
+  printValue("encode_writeFixed", 0, (float)(micros() - start) / ENCODES, "us");
+
+  start = micros();
+  for (uint16_t i = 0; i < ENCODES; i++) {   // what a sketch did before writeInt()
+    nullLink.print(-2000000000L + i);
+  }
+  printValue("encode_print_long", 0, (float)(micros() - start) / ENCODES, "us");
+
+  start = micros();
+  for (uint16_t i = 0; i < ENCODES; i++) {   // and before writeFixed(), with String(value, 2)
+    nullLink.print(-123.45 + i, 2);
+  }
+  printValue("encode_print_float", 0, (float)(micros() - start) / ENCODES, "us");
+}
+
+unsigned long startWrite() {
+  countLink.bytes = 0;
+  return micros();
+}
+
+void printWrite(const char* test, unsigned long baud, unsigned long start) {
+  Serial1.flush();                    // wait until the last byte is on the wire
+  unsigned long time = micros() - start;
+  float perSecond = (float)COMMANDS * 1000000.0 / time;
+  float bytes = (float)countLink.bytes / COMMANDS;  // every byte the library wrote, 0xFF 0xFF 0xFF included
+  printValue(test, baud, perSecond, "cmd/s");
+  printValue(test, baud, bytes, "bytes/cmd");
+  drain();
+}
+
+void printValue(const char* test, unsigned long baud, float value, const char* unit) {
+  REPORT.print(test);
+  REPORT.print(',');
+  REPORT.print(baud);
+  REPORT.print(',');
+  REPORT.print(value, 1);
+  REPORT.print(',');
+  REPORT.println(unit);
+}
+
+void drain() {                        // let the display catch up and read what it answered
+  unsigned long start = millis();
+  while ((millis() - start) < 200) {
+    myNex.listen();
+    myNex.cmdAvail();
+  }
+}
+
+void sortLatency() {                  // insertion sort, READS is small
+  for (uint8_t i = 1; i < READS; i++) {
+    unsigned long value = latency[i];
+    int8_t j = i - 1;
+    while (j >= 0 && latency[j] > value) {
+      latency[j + 1] = latency[j];
+      j--;
+    }
+    latency[j + 1] = value;
+  }
+}
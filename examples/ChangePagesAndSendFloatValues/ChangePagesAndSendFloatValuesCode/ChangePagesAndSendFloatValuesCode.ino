@@ -228,10 +228,9 @@ void refreshPage0(){
     String tempString = String(temperature, 1); // Convert the float value to String, in order to send it to t0 textbox on Nextion
     myNex.writeStr("t0.txt", tempString);       //Write the String value to t0 Textbox component
     
-    int tempInt = temperature*10;    // We convert the float to int, in order to send it to x0 Xfloat component on Nextion
-                                     // We multiply it x10, because Xfloat will put a comma automatically after the last digit
-                                     // if vvs1 is set to 1
-    myNex.writeNum("x0.val", tempInt);
+    myNex.writeFixed("x0.val", temperature, 1);  // Send the float to x0 Xfloat component on Nextion, with 1 decimal (vvs1 is set to 1)
+                                                 // writeFixed() multiplies it x10 and rounds it, because Xfloat will put a comma
+                                                 // automatically before the last digit. Temperatures below 0 are sent right too
     
     lastSentTemperature = temperature;   // We store the last value that we have sent on Nextion, we wait for the next comparison 
                                          // and send data only when the value of temperature changes
@@ -245,8 +244,7 @@ void refreshPage1(){
     String tempString = String(humidity, 1);
     myNex.writeStr("t0.txt", tempString);
     
-    int tempInt = humidity*10;
-    myNex.writeNum("x0.val", tempInt);
+    myNex.writeFixed("x0.val", humidity, 1);
     
     lastSentHumidity = humidity;
   }
@@ -259,8 +257,7 @@ void refreshPage2(){
     String tempString = String(fahrenheit, 1);
     myNex.writeStr("t0.txt", tempString);
     
-    int tempInt = fahrenheit*10;
-    myNex.writeNum("x0.val", tempInt);
+    myNex.writeFixed("x0.val", fahrenheit, 1);
     
     lastSentFahrenheit = fahrenheit;
   }
@@ -273,8 +270,7 @@ void refreshPage3(){
     String tempString = String(heatIndexCelsius, 1);
     myNex.writeStr("t0.txt", tempString);
     
-    int tempInt = heatIndexCelsius*10;
-    myNex.writeNum("x0.val", tempInt);
+    myNex.writeFixed("x0.val", heatIndexCelsius, 1);
     
     lastSentHeatIndexCelsius = heatIndexCelsius;
   }
@@ -283,8 +279,7 @@ void refreshPage3(){
     String tempString = String(heatIndexFahrenheit, 1);
     myNex.writeStr("t1.txt", tempString);
     
-    int tempInt = heatIndexFahrenheit*10;
-    myNex.writeNum("x1.val", tempInt);
+    myNex.writeFixed("x1.val", heatIndexFahrenheit, 1);
     
     lastSentHeatIndexFahrenheit = heatIndexFahrenheit;
   }
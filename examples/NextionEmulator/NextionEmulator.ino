@@ -0,0 +1,338 @@
+/*
+ * NextionEmulator.ino - A Nextion display played by a second board, for testing nextion_ez
+ * All rights reserved under the library's licence
+ */
+
+// Compatible for boards with a second Hardware Serial and at least 4KB of RAM (Arduino Mega, ESP32...)
+
+/* This sketch does NOT use the library. It runs on a second board and answers like a Nextion display,
+ * so you can test how fast your own sketch (with nextion_ez) can talk to a display, without one.
+ *
+ * Connect TX1 of this board to the RX of the board under test, RX1 to its TX, and the two GNDs.
+ * The results are printed on the USB Serial of this board every second.
+ *
+ * What it understands, like a real Nextion:
+ *   x=123        x="text"      get x        add id,ch,val     addt id,ch,qty
+ *   page n       sendme        bkcmd=n      baud=n
+ * It keeps a table of the components (names and values) that have been written.
+ * A "get" of a name never written answers 0x1A (invalid variable).
+ *
+ * What it models:
+ *   - the 1024 byte input buffer of Nextion. When it is full, 0x24 is answered and bytes are lost
+ *   - the time Nextion needs to run each command (EXEC_TIME_US)
+ *   - touch events with the custom protocol of the library, sent every EVENT_TIME ms:
+ *     a trigger (printh 23 02 54 01) and, every PAGE_EVERY events, a page change (printh 23 02 50 xx)
+ */
+
+#define LINK Serial1                  // the Serial that goes to the board under test
+#define START_BAUD 9600
+
+#define EXEC_TIME_US 500              // time to run one command, in microseconds
+#define EVENT_TIME 0                  // ms between touch events, 0 for none
+#define PAGE_EVERY 10                 // every how many events a page change is sent
+#define PAGES 3
+
+#define INPUT_SIZE 1024               // the input buffer of Nextion
+#define COMPONENTS 32                 // components that can be remembered
+#define NAME_SIZE 16
+#define TEXT_SIZE 32
+
+uint8_t input[INPUT_SIZE];            // ring buffer of received bytes
+uint16_t inputHead = 0;
+uint16_t inputCount = 0;
+bool overflowSent = false;
+
+char command[128];                    // the command being run
+uint8_t commandLen = 0;
+uint8_t endBytes = 0;
+
+struct component {
+  char name[NAME_SIZE];
+  bool isText;
+  uint32_t value;
+  char text[TEXT_SIZE];
+};
+component components[COMPONENTS];
+uint8_t componentCount = 0;
+
+uint8_t bkcmd = 2;                    // 2: only errors are answered, 3: every command
+uint8_t currentPage = 0;
+uint16_t rawBytesLeft = 0;            // waveform data of addt still to come
+
+unsigned long lastExec = 0;
+unsigned long lastEvent = 0;
+unsigned long lastReport = 0;
+uint16_t eventCount = 0;
+
+unsigned long commandsRun = 0;        // counters for the report
+unsigned long bytesIn = 0;
+unsigned long bytesLost = 0;
+unsigned long errorsSent = 0;
+unsigned long waveValues = 0;
+
+void setup() {
+  Serial.begin(115200);
+  LINK.begin(START_BAUD);
+  lastReport = millis();
+}
+
+void loop() {
+  receiveBytes();
+
+  if (rawBytesLeft > 0) {            // the data of addt is not a command, take it as it comes
+    takeRawBytes();
+  } else if ((micros() - lastExec) >= EXEC_TIME_US && inputCount > 0) {
+    lastExec = micros();
+    runNextCommand();
+  }
+
+  if (EVENT_TIME > 0 && (millis() - lastEvent) >= EVENT_TIME) {
+    lastEvent = millis();
+    sendEvent();
+  }
+
+  if ((millis() - lastReport) >= 1000) {
+    lastReport = millis();
+    report();
+  }
+}
+
+void receiveBytes() {                 // from the Serial to the 1024 byte buffer, like Nextion does
+  while (LINK.available() > 0) {
+    uint8_t c = LINK.read();
+    bytesIn++;
+    if (inputCount >= INPUT_SIZE) {
+      bytesLost++;
+      if (!overflowSent) {
+        sendCode(0x24);               // serial buffer overflow
+        overflowSent = true;
+      }
+      continue;
+    }
+    uint16_t place = (inputHead + inputCount) % INPUT_SIZE;
+    input[place] = c;
+    inputCount++;
+  }
+}
+
+int takeByte() {
+  if (inputCount == 0) {
+    return -1;
+  }
+  uint8_t c = input[inputHead];
+  inputHead = (inputHead + 1) % INPUT_SIZE;
+  inputCount--;
+  if (inputCount < INPUT_SIZE / 2) {
+    overflowSent = false;
+  }
+  return c;
+}
+
+void takeRawBytes() {
+  while (rawBytesLeft > 0 && inputCount > 0) {
+    takeByte();
+    rawBytesLeft--;
+    waveValues++;
+  }
+  if (rawBytesLeft == 0) {
+    sendCode(0xFD);                   // transparent data finished
+  }
+}
+
+void runNextCommand() {               // reads bytes up to 0xFF 0xFF 0xFF and runs one command
+  while (inputCount > 0) {
+    uint8_t c = takeByte();
+    if (c == 0xFF) {
+      endBytes++;
+      if (endBytes == 3) {
+        command[commandLen] = '\0';
+        runCommand();
+        commandLen = 0;
+        endBytes = 0;
+        return;
+      }
+      continue;
+    }
+    endBytes = 0;
+    if (commandLen < sizeof(command) - 1) {
+      command[commandLen++] = c;
+    }
+  }
+}
+
+void runCommand() {
+  commandsRun++;
+
+  if (strncmp(command, "get ", 4) == 0) {
+    component* comp = findComponent(command + 4, false);
+    if (comp == NULL) {
+      sendError(0x1A);                // invalid variable name
+    } else if (comp->isText) {
+      LINK.write(0x70);
+      LINK.print(comp->text);
+      sendEnd();
+    } else {
+      LINK.write(0x71);
+      LINK.write((uint8_t)(comp->value));
+      LINK.write((uint8_t)(comp->value >> 8));
+      LINK.write((uint8_t)(comp->value >> 16));
+      LINK.write((uint8_t)(comp->value >> 24));
+      sendEnd();
+    }
+    return;
+  }
+
+  if (strncmp(command, "addt ", 5) == 0) {
+    char* p = command + 5;
+    strtoul(p, &p, 10);               // waveform id
+    p++;
+    strtoul(p, &p, 10);               // channel
+    p++;
+    rawBytesLeft = strtoul(p, NULL, 10);
+    sendCode(0xFE);                   // transparent data ready
+    return;
+  }
+
+  if (strncmp(command, "add ", 4) == 0) {
+    waveValues++;
+    sendSuccess();
+    return;
+  }
+
+  if (strncmp(command, "page ", 5) == 0) {
+    currentPage = atoi(command + 5);
+    componentCount = 0;               // local components are loaded again from the HMI
+    sendSuccess();
+    LINK.write('#');                  // the preinitialize event of the page: printh 23 02 50 xx
+    LINK.write(0x02);
+    LINK.write('P');
+    LINK.write(currentPage);
+    return;
+  }
+
+  if (strcmp(command, "sendme") == 0) {
+    LINK.write(0x66);
+    LINK.write(currentPage);
+    sendEnd();
+    return;
+  }
+
+  char* equal = strchr(command, '=');
+  if (equal == NULL) {
+    sendError(0x00);                  // invalid instruction
+    return;
+  }
+  *equal = '\0';
+  char* value = equal + 1;
+
+  if (strcmp(command, "bkcmd") == 0) {
+    bkcmd = atoi(value);
+    sendSuccess();
+    return;
+  }
+
+  if (strcmp(command, "baud") == 0) {
+    sendSuccess();
+    LINK.flush();
+    LINK.begin(strtoul(value, NULL, 10));
+    return;
+  }
+
+  component* comp = findComponent(command, true);
+  if (comp == NULL) {
+    sendError(0x1A);                  // the table is full, like a name that does not exist
+    return;
+  }
+  if (value[0] == '"') {
+    comp->isText = true;
+    value++;
+    char* quote = strrchr(value, '"');
+    if (quote != NULL) *quote = '\0';
+    strncpy(comp->text, value, TEXT_SIZE - 1);
+    comp->text[TEXT_SIZE - 1] = '\0';
+  } else {
+    comp->isText = false;
+    comp->value = strtoul(value, NULL, 10);
+  }
+  sendSuccess();
+}
+
+component* findComponent(const char* name, bool create) {
+  for (uint8_t i = 0; i < componentCount; i++) {
+    if (strcmp(components[i].name, name) == 0) {
+      return &components[i];
+    }
+  }
+  if (!create || componentCount >= COMPONENTS) {
+    return NULL;
+  }
+  component* comp = &components[componentCount++];
+  strncpy(comp->name, name, NAME_SIZE - 1);
+  comp->name[NAME_SIZE - 1] = '\0';
+  comp->isText = false;
+  comp->value = 0;
+  comp->text[0] = '\0';
+  return comp;
+}
+
+void sendEvent() {                    // a touch event with the custom protocol of the library
+  eventCount++;
+  if (PAGE_EVERY > 0 && (eventCount % PAGE_EVERY) == 0) {
+    currentPage = (currentPage + 1) % PAGES;
+    componentCount = 0;
+    LINK.write('#');                  // printh 23 02 50 xx
+    LINK.write(0x02);
+    LINK.write('P');
+    LINK.write(currentPage);
+  } else {
+    LINK.write('#');                  // printh 23 02 54 01
+    LINK.write(0x02);
+    LINK.write('T');
+    LINK.write(0x01);
+  }
+}
+
+void sendSuccess() {
+  if (bkcmd == 1 || bkcmd == 3) {
+    sendCode(0x01);
+  }
+}
+
+void sendError(uint8_t code) {
+  errorsSent++;
+  if (bkcmd >= 2) {
+    sendCode(code);
+  }
+}
+
+void sendCode(uint8_t code) {
+  LINK.write(code);
+  sendEnd();
+}
+
+void sendEnd() {
+  LINK.write(0xFF);
+  LINK.write(0xFF);
+  LINK.write(0xFF);
+}
+
+void report() {                       // one line per second, easy to copy to a spreadsheet
+  Serial.print("commands/s,");
+  Serial.print(commandsRun);
+  Serial.print(",bytes/s,");
+  Serial.print(bytesIn);
+  Serial.print(",lost,");
+  Serial.print(bytesLost);
+  Serial.print(",errors,");
+  Serial.print(errorsSent);
+  Serial.print(",wave/s,");
+  Serial.print(waveValues);
+  Serial.print(",buffer,");
+  Serial.println(inputCount);
+
+  commandsRun = 0;
+  bytesIn = 0;
+  bytesLost = 0;
+  errorsSent = 0;
+  waveValues = 0;
+}
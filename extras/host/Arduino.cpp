@@ -0,0 +1,457 @@
+/*
+ * Arduino.cpp - the clock, String, Print and HardwareSerial of the PC build
+ * All rights reserved under the library's licence
+ */
+
+#include "Arduino.h"
+
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+  //------------------------------------------------------
+ // the clock, shared by every thread with one lock
+//--------------------------------------------------------
+static std::recursive_mutex hostLock;
+static uint64_t hostNow = 0;              // microseconds of the virtual clock
+static unsigned long hostStep = 1;
+static bool hostReal = false;
+static bool hostInHook = false;
+static hostTickHook hostHook = NULL;
+static std::chrono::steady_clock::time_point hostStart = std::chrono::steady_clock::now();
+
+static std::vector<HardwareSerial*>& hostPorts(){  // made on first use, before the Serials below
+  static std::vector<HardwareSerial*> ports;
+  return ports;
+}
+
+static uint64_t hostTime(){
+  if(hostReal){
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - hostStart).count();
+  }
+  return hostNow;
+}
+
+static void hostUpdate(){                 // every Serial up to now
+  uint64_t now = hostTime();
+  std::vector<HardwareSerial*>& ports = hostPorts();
+  for(size_t i = 0; i < ports.size(); i++){
+    ports[i]->update(now);
+  }
+}
+
+void hostAdvance(unsigned long us){
+  std::unique_lock<std::recursive_mutex> lock(hostLock);
+  if(hostReal){
+    lock.unlock();                        // the other threads go on while this one sleeps
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+    lock.lock();
+    hostUpdate();
+    return;
+  }
+  while(us > 0){                          // small steps, so the hook sees every byte in time
+    unsigned long step = (us > 50) ? 50 : us;
+    hostNow += step;
+    us -= step;
+    hostUpdate();
+    if(hostHook != NULL && !hostInHook){
+      hostInHook = true;
+      hostHook();
+      hostInHook = false;
+    }
+  }
+}
+
+void hostTimeStep(unsigned long us){
+  std::lock_guard<std::recursive_mutex> lock(hostLock);
+  hostStep = us;
+}
+
+void hostRealTime(bool on){
+  std::lock_guard<std::recursive_mutex> lock(hostLock);
+  hostReal = on;
+  hostStart = std::chrono::steady_clock::now();
+}
+
+void hostOnTick(hostTickHook hook){
+  std::lock_guard<std::recursive_mutex> lock(hostLock);
+  hostHook = hook;
+}
+
+void hostReset(){
+  std::lock_guard<std::recursive_mutex> lock(hostLock);
+  hostNow = 0;
+  hostStep = 1;
+  hostReal = false;
+  hostHook = NULL;
+  std::vector<HardwareSerial*>& ports = hostPorts();
+  for(size_t i = 0; i < ports.size(); i++){
+    ports[i]->end();
+    ports[i]->clear();
+    ports[i]->connect(*ports[i]);
+  }
+}
+
+static uint64_t hostRead(){               // a read of the clock moves it a little, so waiting loops end
+  std::lock_guard<std::recursive_mutex> lock(hostLock);
+  if(!hostReal && !hostInHook && hostStep > 0){
+    hostAdvance(hostStep);
+  }
+  return hostTime();
+}
+
+unsigned long millis(){
+  return (unsigned long)(hostRead() / 1000);
+}
+
+unsigned long micros(){
+  return (unsigned long)hostRead();
+}
+
+void delay(unsigned long ms){
+  hostAdvance(ms * 1000UL);
+}
+
+void delayMicroseconds(unsigned int us){
+  hostAdvance(us);
+}
+
+void yield(){
+  if(hostReal){
+    std::this_thread::yield();
+  }
+}
+
+  //------------------------------------------------------
+ // String
+//--------------------------------------------------------
+String::String(const char* text) : _buffer(NULL), _length(0), _capacity(0){
+  copy(text, strlen(text));
+}
+
+String::String(const String& other) : _buffer(NULL), _length(0), _capacity(0){
+  copy(other.c_str(), other._length);
+}
+
+String::String(const __FlashStringHelper* text) : _buffer(NULL), _length(0), _capacity(0){
+  const char* p = reinterpret_cast<const char*>(text);
+  copy(p, strlen(p));
+}
+
+String::~String(){
+  delete[] _buffer;
+}
+
+String& String::operator=(const String& other){
+  if(this != &other){
+    copy(other.c_str(), other._length);
+  }
+  return *this;
+}
+
+String& String::operator=(const char* text){
+  copy(text, strlen(text));
+  return *this;
+}
+
+String& String::operator+=(char c){
+  reserve(_length + 1);
+  _buffer[_length++] = c;
+  _buffer[_length] = '\0';
+  return *this;
+}
+
+String& String::operator+=(const char* text){
+  unsigned int length = strlen(text);
+  reserve(_length + length);
+  memcpy(_buffer + _length, text, length + 1);
+  _length += length;
+  return *this;
+}
+
+String& String::operator+=(const String& other){
+  String copy(other);                     // also right for s += s
+  return *this += copy.c_str();
+}
+
+bool String::operator==(const char* text) const{
+  return strcmp(c_str(), text) == 0;
+}
+
+bool String::operator==(const String& other) const{
+  return _length == other._length && strcmp(c_str(), other.c_str()) == 0;
+}
+
+char String::operator[](unsigned int index) const{
+  return index < _length ? _buffer[index] : '\0';
+}
+
+void String::reserve(unsigned int size){  // grows like the core, a new buffer only when needed
+  if(size < _capacity){
+    return;
+  }
+  unsigned int capacity = (_capacity < 8) ? 8 : _capacity;
+  while(capacity <= size) capacity *= 2;
+  char* buffer = new char[capacity];
+  if(_buffer != NULL){
+    memcpy(buffer, _buffer, _length + 1);
+    delete[] _buffer;
+  }else{
+    buffer[0] = '\0';
+  }
+  _buffer = buffer;
+  _capacity = capacity;
+}
+
+void String::copy(const char* text, unsigned int length){
+  if(length == 0 && _buffer == NULL){
+    return;                               // "" needs no memory
+  }
+  reserve(length);
+  memmove(_buffer, text, length);
+  _buffer[length] = '\0';
+  _length = length;
+}
+
+  //------------------------------------------------------
+ // Print, numbers are made with divisions as the core does
+//--------------------------------------------------------
+size_t Print::write(const uint8_t* buffer, size_t size){
+  size_t n = 0;
+  while(size-- > 0){
+    n += write(*buffer++);
+  }
+  return n;
+}
+
+size_t Print::printNumber(unsigned long value, uint8_t base){
+  char buffer[8 * sizeof(long) + 1];
+  char* p = &buffer[sizeof(buffer) - 1];
+  *p = '\0';
+  do{
+    char digit = value % base;
+    value /= base;
+    *--p = digit < 10 ? digit + '0' : digit + 'A' - 10;
+  }while(value > 0);
+  return write(p);
+}
+
+size_t Print::print(long value, int base){
+  if(base == DEC && value < 0){
+    size_t n = print('-');
+    return n + printNumber(0UL - (unsigned long)value, DEC);
+  }
+  return printNumber((unsigned long)value, base);
+}
+
+size_t Print::print(unsigned long value, int base){
+  return printNumber(value, base);
+}
+
+size_t Print::print(double value, int digits){
+  size_t n = 0;
+  if(value < 0.0){
+    n += print('-');
+    value = -value;
+  }
+  double rounding = 0.5;
+  for(int i = 0; i < digits; i++){
+    rounding /= 10.0;
+  }
+  value += rounding;
+  unsigned long whole = (unsigned long)value;
+  double rest = value - (double)whole;
+  n += printNumber(whole, DEC);
+  if(digits > 0){
+    n += print('.');
+  }
+  while(digits-- > 0){
+    rest *= 10.0;
+    unsigned int digit = (unsigned int)rest;
+    n += print((char)('0' + digit));
+    rest -= digit;
+  }
+  return n;
+}
+
+  //------------------------------------------------------
+ // HardwareSerial
+//--------------------------------------------------------
+HardwareSerial Serial;
+HardwareSerial Serial1;
+HardwareSerial Serial2;
+
+HardwareSerial::HardwareSerial(uint16_t rxSize, uint16_t txSize){
+  _peer = this;
+  _baud = 0;
+  _byteTime = 0;
+  _rx = NULL;
+  _tx = NULL;
+  setBuffers(rxSize, txSize);
+  std::lock_guard<std::recursive_mutex> lock(hostLock);
+  hostPorts().push_back(this);
+}
+
+HardwareSerial::~HardwareSerial(){
+  std::lock_guard<std::recursive_mutex> lock(hostLock);
+  std::vector<HardwareSerial*>& ports = hostPorts();
+  for(size_t i = 0; i < ports.size(); i++){
+    if(ports[i] == this){
+      ports.erase(ports.begin() + i);
+      break;
+    }
+  }
+  for(size_t i = 0; i < ports.size(); i++){
+    if(ports[i]->_peer == this){
+      ports[i]->_peer = ports[i];
+    }
+  }
+  delete[] _rx;
+  delete[] _tx;
+}
+
+void HardwareSerial::setBuffers(uint16_t rxSize, uint16_t txSize){
+  std::lock_guard<std::recursive_mutex> lock(hostLock);
+  delete[] _rx;
+  delete[] _tx;
+  _rxSize = rxSize;
+  _txSize = txSize;
+  _rx = new uint8_t[rxSize];
+  _tx = new uint8_t[txSize];
+  clear();
+}
+
+void HardwareSerial::clear(){
+  std::lock_guard<std::recursive_mutex> lock(hostLock);
+  _rxHead = 0;
+  _rxCount = 0;
+  _txHead = 0;
+  _txCount = 0;
+  _sent = 0;
+  _lost = 0;
+  _nextDone = 0;
+}
+
+void HardwareSerial::connect(HardwareSerial& other){
+  std::lock_guard<std::recursive_mutex> lock(hostLock);
+  if(_peer != this && _peer != &other){
+    _peer->_peer = _peer;                 // the old peer is alone again
+  }
+  _peer = &other;
+  other._peer = this;
+}
+
+void HardwareSerial::begin(unsigned long baud){
+  std::lock_guard<std::recursive_mutex> lock(hostLock);
+  update(hostTime());                     // the bytes already on the wire go at the old rate
+  _baud = baud;
+  _byteTime = (baud > 0) ? 10000000.0 / baud : 0;
+}
+
+void HardwareSerial::end(){
+  std::lock_guard<std::recursive_mutex> lock(hostLock);
+  _baud = 0;
+  _byteTime = 0;
+}
+
+int HardwareSerial::available(){
+  std::lock_guard<std::recursive_mutex> lock(hostLock);
+  if(hostReal) hostUpdate();
+  return _rxCount;
+}
+
+int HardwareSerial::read(){
+  std::lock_guard<std::recursive_mutex> lock(hostLock);
+  if(hostReal) hostUpdate();
+  if(_rxCount == 0){
+    return -1;
+  }
+  uint8_t c = _rx[_rxHead];
+  _rxHead = (_rxHead + 1) % _rxSize;
+  _rxCount--;
+  return c;
+}
+
+int HardwareSerial::peek(){
+  std::lock_guard<std::recursive_mutex> lock(hostLock);
+  if(hostReal) hostUpdate();
+  return (_rxCount == 0) ? -1 : _rx[_rxHead];
+}
+
+size_t HardwareSerial::write(uint8_t c){
+  return write(&c, 1);
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size){
+  std::unique_lock<std::recursive_mutex> lock(hostLock);
+  for(size_t i = 0; i < size; i++){
+    while(_txCount >= _txSize){           // the ring is full: wait for a byte to leave, as the core does
+      if(hostReal){
+        lock.unlock();
+        std::this_thread::sleep_for(std::chrono::microseconds(20));
+        lock.lock();
+        hostUpdate();
+      }else{
+        double wait = _nextDone - (double)hostNow;
+        hostAdvance(wait > 1 ? (unsigned long)wait + 1 : 1);
+      }
+    }
+    uint64_t now = hostTime();
+    if(_txCount == 0 && _nextDone < (double)now){
+      _nextDone = (double)now + _byteTime;  // the line was idle, this byte starts now
+    }
+    _tx[(_txHead + _txCount) % _txSize] = buffer[i];
+    _txCount++;
+    if(_baud == 0){
+      update(now);
+    }
+  }
+  return size;
+}
+
+int HardwareSerial::availableForWrite(){
+  std::lock_guard<std::recursive_mutex> lock(hostLock);
+  if(hostReal) hostUpdate();
+  return _txSize - _txCount;
+}
+
+void HardwareSerial::flush(){
+  std::unique_lock<std::recursive_mutex> lock(hostLock);
+  while(_txCount > 0){
+    if(hostReal){
+      lock.unlock();
+      std::this_thread::sleep_for(std::chrono::microseconds(20));
+      lock.lock();
+      hostUpdate();
+    }else{
+      double wait = _nextDone - (double)hostNow;
+      hostAdvance(wait > 1 ? (unsigned long)wait + 1 : 1);
+    }
+  }
+}
+
+void HardwareSerial::update(uint64_t now){
+  while(_txCount > 0){
+    if(_baud != 0 && _nextDone > (double)now){
+      break;                              // the byte is still on the wire
+    }
+    uint8_t c = _tx[_txHead];
+    _txHead = (_txHead + 1) % _txSize;
+    _txCount--;
+    _sent++;
+    _peer->receive(c, _baud);
+    if(_baud != 0 && _txCount > 0){
+      _nextDone += _byteTime;
+    }
+  }
+}
+
+void HardwareSerial::receive(uint8_t c, unsigned long baud){
+  if((baud != 0 && _baud != 0 && baud != _baud) || _rxCount >= _rxSize){
+    _lost++;                              // a wrong baud rate gives garbage, a full ring overruns
+    return;
+  }
+  _rx[(_rxHead + _rxCount) % _rxSize] = c;
+  _rxCount++;
+}
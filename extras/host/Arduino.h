@@ -0,0 +1,184 @@
+/*
+ * Arduino.h - the part of the Arduino core that nextion_ez uses, to build and test it on a PC
+ * All rights reserved under the library's licence
+ *
+ * Only for the build of extras/host, the Arduino IDE never sees this file.
+ *
+ * The clock is virtual: it only moves when the code reads it (every millis() or micros() moves it
+ * by hostTimeStep() microseconds) and with delay(), so every run gives the same result.
+ * hostRealTime(true) uses the clock of the PC instead, for tests with threads.
+ *
+ * HardwareSerial keeps a receive and a transmit ring like the core of a board. The bytes written
+ * leave the transmit ring at the speed of the baud rate and arrive in the receive ring of the
+ * other end: the port given to connect(), or the same port if it is not connected (loopback).
+ */
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+
+typedef uint8_t byte;
+
+  //------------------------------------------------------
+ // time
+//--------------------------------------------------------
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield(void);
+
+typedef void (*hostTickHook)(void);
+
+void hostAdvance(unsigned long us);       // moves the virtual clock, the Serials and the hook along
+void hostTimeStep(unsigned long us);      // how much each millis() or micros() moves the virtual clock (default 1)
+void hostRealTime(bool on);               // true: the clock of the PC, for tests with threads
+void hostOnTick(hostTickHook hook);       // called each time the virtual clock moves, to play the other end of a Serial
+void hostReset(void);                     // clock back to 0, every Serial emptied and not connected, no hook
+
+  //------------------------------------------------------
+ // flash memory, on a PC it is the same as RAM
+//--------------------------------------------------------
+#define PROGMEM
+class __FlashStringHelper;
+#define F(text) (reinterpret_cast<const __FlashStringHelper*>(text))
+#define pgm_read_byte(p)  (*(const uint8_t*)(p))
+#define pgm_read_word(p)  hostReadWord(p)
+#define pgm_read_dword(p) hostReadDword(p)
+static inline uint16_t hostReadWord(const void* p){   // memcpy, the table may be of an other type
+  uint16_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+static inline uint32_t hostReadDword(const void* p){
+  uint32_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+#define memcpy_P memcpy
+#define strlen_P strlen
+
+  //------------------------------------------------------
+ // String, only what a sketch and the library need
+//--------------------------------------------------------
+class String {
+  public:
+    String(const char* text = "");
+    String(const String& other);
+    String(const __FlashStringHelper* text);
+    ~String();
+    String& operator=(const String& other);
+    String& operator=(const char* text);
+    String& operator+=(char c);
+    String& operator+=(const char* text);
+    String& operator+=(const String& other);
+    bool operator==(const char* text) const;
+    bool operator==(const String& other) const;
+    bool operator!=(const char* text) const { return !(*this == text); }
+    char operator[](unsigned int index) const;
+    const char* c_str() const { return _buffer != NULL ? _buffer : ""; }
+    unsigned int length() const { return _length; }
+
+  private:
+    char* _buffer;                        // with new[], so a test can count the allocations
+    unsigned int _length;
+    unsigned int _capacity;
+    void reserve(unsigned int size);
+    void copy(const char* text, unsigned int length);
+};
+
+  //------------------------------------------------------
+ // Print and Stream
+//--------------------------------------------------------
+#define DEC 10
+#define HEX 16
+
+class Print {
+  public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size);
+    size_t write(const char* text) { return text == NULL ? 0 : write((const uint8_t*)text, strlen(text)); }
+    size_t write(const char* buffer, size_t size) { return write((const uint8_t*)buffer, size); }
+    virtual int availableForWrite() { return 0; }
+    virtual void flush() {}
+
+    size_t print(const char* text) { return write(text); }
+    size_t print(const __FlashStringHelper* text) { return write(reinterpret_cast<const char*>(text)); }
+    size_t print(const String& text) { return write((const uint8_t*)text.c_str(), text.length()); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(unsigned char value, int base = DEC) { return print((unsigned long)value, base); }
+    size_t print(int value, int base = DEC) { return print((long)value, base); }
+    size_t print(unsigned int value, int base = DEC) { return print((unsigned long)value, base); }
+    size_t print(long value, int base = DEC);
+    size_t print(unsigned long value, int base = DEC);
+    size_t print(double value, int digits = 2);
+    size_t println(void) { return write("\r\n"); }
+    template <typename T> size_t println(T value) { size_t n = print(value); return n + println(); }
+    template <typename T> size_t println(T value, int format) { size_t n = print(value, format); return n + println(); }
+
+  private:
+    size_t printNumber(unsigned long value, uint8_t base);  // with divisions, like the core
+};
+
+class Stream : public Print {
+  public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+};
+
+  //------------------------------------------------------
+ // HardwareSerial with a wire of its own
+//--------------------------------------------------------
+class HardwareSerial : public Stream {
+  public:
+    HardwareSerial(uint16_t rxSize = 64, uint16_t txSize = 64);
+    ~HardwareSerial();
+    void begin(unsigned long baud);
+    void end();
+    int available();
+    int read();
+    int peek();
+    size_t write(uint8_t c);
+    size_t write(const uint8_t* buffer, size_t size);
+    using Print::write;
+    int availableForWrite();
+    void flush();                         // waits until the last byte is on the wire, like the core
+    operator bool() { return true; }
+
+    void connect(HardwareSerial& other);  // TX of each one to RX of the other. Not connected, TX goes to its own RX
+    void setBuffers(uint16_t rxSize, uint16_t txSize);
+    unsigned long baud() const { return _baud; }
+    uint32_t sentBytes() const { return _sent; }    // bytes that left on the wire
+    uint32_t lostBytes() const { return _lost; }    // bytes that arrived with the RX ring full, or at an other baud rate
+    void clear();                         // empties both rings, a new start
+
+    void update(uint64_t now);            // moves the bytes whose time has come, called by the clock
+
+  private:
+    HardwareSerial* _peer;
+    unsigned long _baud;                  // 0: no pacing, the bytes arrive at once
+    double _byteTime;                     // microseconds of one byte (start, 8 data, stop bits)
+    double _nextDone;                     // when the byte on the wire has arrived
+    uint8_t* _rx;
+    uint16_t _rxSize;
+    uint16_t _rxHead;
+    uint16_t _rxCount;
+    uint8_t* _tx;
+    uint16_t _txSize;
+    uint16_t _txHead;
+    uint16_t _txCount;
+    uint32_t _sent;
+    uint32_t _lost;
+    void receive(uint8_t c, unsigned long baud);
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial1;
+extern HardwareSerial Serial2;
+
+#endif
@@ -0,0 +1,130 @@
+/*
+ * bench_commands.cpp - CPU time of one command, the print() calls of the first versions against the
+ * transmit buffer of now. Runs on the PC build, the Serial is a sink that keeps nothing.
+ * All rights reserved under the library's licence
+ *
+ *   bench_commands [commands]    prints CSV: case,commands,ns_per_cmd,cycles_per_cmd,bytes_per_cmd
+ *
+ * The sink stores each byte in a 64 byte ring, one virtual write() per byte like the AVR core,
+ * so the numbers show the cost of building the command, not of a real UART.
+ * cycles_per_cmd is read with rdtsc on x86, 0 elsewhere.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#include "Arduino.h"
+#include "nextion_ez.h"
+
+class sinkSerial : public Stream {        // takes every byte at once, nothing ever arrives
+  public:
+    sinkSerial() : bytes(0), _head(0) {}
+    unsigned long bytes;
+    size_t write(uint8_t c){
+      _ring[_head] = c;
+      _head = (_head + 1) & 63;
+      bytes++;
+      return 1;
+    }
+    using Print::write;
+    int availableForWrite() { return 64; }
+    int available() { return 0; }
+    int read() { return -1; }
+    int peek() { return -1; }
+  private:
+    uint8_t _ring[64];
+    uint8_t _head;
+};
+
+  //------------------------------------------------------
+ // the writes of the first versions, one print() per part
+//--------------------------------------------------------
+static String oldComponent;
+static String oldText;
+
+static void oldWriteNum(Stream& serial, String compName, uint32_t val){
+  oldComponent = compName;
+  serial.print(oldComponent);
+  serial.print("=");
+  serial.print((unsigned long)val);
+  serial.print("\xFF\xFF\xFF");
+}
+
+static void oldWriteStr(Stream& serial, String command, String txt){
+  oldComponent = command;
+  oldText = txt;
+  serial.print(oldComponent);
+  serial.print("=\"");
+  serial.print(oldText);
+  serial.print("\"");
+  serial.print("\xFF\xFF\xFF");
+}
+
+static void oldSendCmd(Stream& serial, String command){
+  oldComponent = command;
+  serial.print(oldComponent);
+  serial.print("\xFF\xFF\xFF");
+}
+
+NEX_COMPONENT(speed, "n0.val");
+
+static uint64_t cycles(){
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+static volatile uint32_t sink;            // keeps the compiler from removing the loops
+
+template <typename F>
+static void run(const char* name, sinkSerial& serial, long count, F command){
+  for(long i = 0; i < count / 10; i++){   // warm up
+    command((uint32_t)i);
+  }
+  double bestNs = 0;
+  uint64_t bestCycles = 0;
+  for(int round = 0; round < 5; round++){ // the best of 5, the others were slowed down by the system
+    serial.bytes = 0;
+    auto start = std::chrono::steady_clock::now();
+    uint64_t startCycles = cycles();
+    for(long i = 0; i < count; i++){
+      command((uint32_t)(i * 7919UL));    // values of 1 to 10 digits
+    }
+    uint64_t endCycles = cycles();
+    auto end = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(end - start).count();
+    if(round == 0 || ns < bestNs){
+      bestNs = ns;
+      bestCycles = endCycles - startCycles;
+    }
+  }
+  sink = serial.bytes;
+  printf("%s,%ld,%.1f,%.0f,%.1f\n", name, count, bestNs / count,
+         (double)bestCycles / count, (double)serial.bytes / count);
+}
+
+int main(int argc, char** argv){
+  long count = (argc > 1) ? atol(argv[1]) : 1000000L;
+  if(count < 10) count = 10;
+  sinkSerial serial;
+  nextion_ez myNex(serial);
+  myNex.begin();
+
+  printf("case,commands,ns_per_cmd,cycles_per_cmd,bytes_per_cmd\n");
+  run("writeNum_print", serial, count, [&](uint32_t v){ oldWriteNum(serial, "n0.val", v); });
+  run("writeNum_char", serial, count, [&](uint32_t v){ myNex.writeNum("n0.val", v); });
+  run("writeNum_handle", serial, count, [&](uint32_t v){ myNex.writeNum(speed, v); });
+  run("writeStr_print", serial, count, [&](uint32_t){ oldWriteStr(serial, "t0.txt", "Hello World"); });
+  run("writeStr_char", serial, count, [&](uint32_t){ myNex.writeStr("t0.txt", "Hello World"); });
+  run("sendCmd_print", serial, count, [&](uint32_t){ oldSendCmd(serial, "page 1"); });
+  run("sendCmd_char", serial, count, [&](uint32_t){ myNex.sendCmd("page 1"); });
+  myNex.beginBatch();
+  run("writeNum_batch", serial, count, [&](uint32_t v){ myNex.writeNum(speed, v); });
+  myNex.flush();
+  return 0;
+}
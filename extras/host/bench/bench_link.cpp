@@ -0,0 +1,125 @@
+/*
+ * bench_link.cpp - the Benchmark example on the PC build, against the emulator of test/emulator.h
+ * All rights reserved under the library's licence
+ *
+ *   bench_link [commands]    prints CSV: test,baud,value,unit
+ *
+ * For 9600, 115200 and 921600 baud it measures, on the virtual clock:
+ *   - commands per second and bytes on the wire per command of writeNum(), writeStr(), sendCmd()
+ *     and addWave(), values per second of streamWave(), and the bytes the emulator lost
+ *   - the round trip time of readNum(), p50 and p99
+ * and, with the clock of the PC, the CPU time listen() needs for each byte, while the emulator
+ * sends an event every ms. The virtual clock stands still meanwhile, so the emulator is not timed.
+ * The emulator runs each command in 500us, like the example sketch.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "Arduino.h"
+#include "emulator.h"
+#include "nextion_ez.h"
+
+static long commands = 200;               // commands sent for each write test, and readNum() calls
+
+static void printValue(const char* test, unsigned long baud, double value, const char* unit){
+  printf("%s,%lu,%.1f,%s\n", test, baud, value, unit);
+}
+
+static void drain(nextion_ez& myNex){     // let the emulator catch up and read what it answered
+  unsigned long start = millis();
+  while(millis() - start < 200){
+    myNex.listen();
+    while(myNex.cmdAvail()){
+      myNex.getCmd();
+    }
+  }
+}
+
+template <typename F>
+static void runWrite(const char* test, unsigned long baud, nextion_ez& myNex, testEmulator& nextion, F command){
+  uint32_t sent = Serial2.sentBytes();
+  unsigned long lost = nextion.lostBytes;
+  unsigned long start = micros();
+  for(long i = 0; i < commands; i++){
+    command((uint32_t)i);
+  }
+  Serial2.flush();                        // wait until the last byte is on the wire
+  unsigned long time = micros() - start;
+  printValue(test, baud, commands * 1000000.0 / time, "cmd/s");
+  printValue(test, baud, (double)(Serial2.sentBytes() - sent) / commands, "bytes/cmd");
+  drain(myNex);
+  printValue(test, baud, nextion.lostBytes - lost, "lost_bytes");
+}
+
+static void runBaud(unsigned long baud){
+  hostReset();
+  testEmulator nextion(Serial1);
+  nextion.waveIds.push_back(1);
+  nextion.numbers["n0.val"] = 12345;
+  Serial1.connect(Serial2);
+  Serial1.begin(baud);
+  nextion_ez myNex(Serial2);
+  myNex.begin(baud);
+
+  runWrite("writeNum", baud, myNex, nextion, [&](uint32_t i){ myNex.writeNum("n0.val", i); });
+  runWrite("writeStr", baud, myNex, nextion, [&](uint32_t){ myNex.writeStr("t0.txt", "Hello World"); });
+  runWrite("sendCmd", baud, myNex, nextion, [&](uint32_t){ myNex.sendCmd("ref 0"); });
+  runWrite("addWave", baud, myNex, nextion, [&](uint32_t i){ myNex.addWave(1, 0, (uint8_t)i); });
+
+  unsigned long start = micros();
+  long values = 0;
+  while(values < commands * 8){           // streamWave() is sent by listen(), so call it in the loop
+    if(myNex.streamWave(1, 0, (uint8_t)values)){
+      values++;
+    }
+    myNex.listen();
+  }
+  Serial2.flush();
+  printValue("streamWave", baud, values * 1000000.0 / (micros() - start), "values/s");
+  myNex.sendWave();
+  drain(myNex);
+
+  std::vector<unsigned long> latency;
+  for(long i = 0; i < commands; i++){
+    start = micros();
+    myNex.readNum("n0.val");
+    latency.push_back(micros() - start);
+  }
+  std::sort(latency.begin(), latency.end());
+  printValue("readNum_p50", baud, latency[latency.size() / 2] / 1000.0, "ms");
+  printValue("readNum_p99", baud, latency[(latency.size() * 99) / 100] / 1000.0, "ms");
+
+  nextion.eventTime = 1;
+  double busy = 0;
+  unsigned long bytes = 0;
+  hostTimeStep(0);                        // the clock stands still in listen(), only the library is timed
+  start = millis();
+  while(millis() - start < 200){
+    delayMicroseconds(100);               // the bytes arrive meanwhile
+    int before = Serial2.available();
+    auto t = std::chrono::steady_clock::now();
+    myNex.listen();
+    busy += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t).count();
+    int after = Serial2.available();
+    if(before > after) bytes += before - after;
+    while(myNex.cmdAvail()){              // take the events, as a sketch would
+      myNex.getCmd();
+    }
+  }
+  hostTimeStep(1);
+  printValue("listen_ns_per_byte", baud, bytes > 0 ? busy / bytes : 0, "ns");
+}
+
+int main(int argc, char** argv){
+  commands = (argc > 1) ? atol(argv[1]) : 200;
+  if(commands < 1) commands = 1;
+  printf("test,baud,value,unit\n");
+  const unsigned long rates[] = {9600, 115200, 921600};
+  for(unsigned long baud : rates){
+    runBaud(baud);
+  }
+  return 0;
+}
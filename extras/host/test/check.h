@@ -0,0 +1,38 @@
+/*
+ * check.h - the few macros the tests of the PC build need
+ * All rights reserved under the library's licence
+ */
+#ifndef check_h
+#define check_h
+
+#include <stdio.h>
+#include "Arduino.h"
+
+static int checkFailures = 0;
+
+#define CHECK(condition) do{ \
+    if(!(condition)){ \
+      printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+      checkFailures++; \
+    } \
+  }while(0)
+
+#define CHECK_EQUAL(expected, actual) do{ \
+    long long e_ = (long long)(expected); \
+    long long a_ = (long long)(actual); \
+    if(e_ != a_){ \
+      printf("%s:%d: %s is %lld, expected %lld\n", __FILE__, __LINE__, #actual, a_, e_); \
+      checkFailures++; \
+    } \
+  }while(0)
+
+#define RUN(test) do{ \
+    hostReset(); \
+    int before_ = checkFailures; \
+    test(); \
+    printf("%s %s\n", (checkFailures == before_) ? "ok  " : "FAIL", #test); \
+  }while(0)
+
+#define CHECK_RESULT() (checkFailures == 0 ? 0 : 1)
+
+#endif
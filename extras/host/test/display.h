@@ -0,0 +1,160 @@
+/*
+ * display.h - a small scripted Nextion for the tests of the PC build
+ * All rights reserved under the library's licence
+ *
+ * It sits on the other end of a HardwareSerial and is run by the virtual clock (hostOnTick()).
+ * It keeps the commands it got, answers "get" from its tables, and answers 0x1A to a name that is
+ * not in them or that starts with "bad". With bkcmd=1 or 3 every good command gets 0x01.
+ * "baud=" changes the baud rate of its port, like a Nextion.
+ * "addt" of a waveform in waveIds answers 0xFE, takes the raw bytes into waveData and answers 0xFD;
+ * of an other id it answers 0x02.
+ * testEmulator (emulator.h) builds on it, with the timing of a real Nextion.
+ */
+#ifndef display_h
+#define display_h
+
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+#include "Arduino.h"
+
+class testDisplay {
+  public:
+    testDisplay(HardwareSerial& port) : bkcmd(2), page(0), answer(true), _port(port), _ends(0), _rawLeft(0){
+      _current = this;
+      hostOnTick(tick);
+    }
+    virtual ~testDisplay(){
+      if(_current == this){
+        hostOnTick(NULL);
+        _current = NULL;
+      }
+    }
+
+    std::vector<std::string> commands;    // every command received, without 0xFF 0xFF 0xFF
+    std::map<std::string, uint32_t> numbers;
+    std::map<std::string, std::string> texts;
+    uint8_t bkcmd;
+    uint8_t page;
+    bool answer;                          // false: the commands are kept, nothing is answered
+    std::vector<uint8_t> waveIds;         // the waveforms addt can write to
+    std::vector<uint8_t> waveData;        // the raw bytes of every addt
+
+    void send(const std::vector<uint8_t>& bytes){
+      _port.write(bytes.data(), bytes.size());
+    }
+    void sendEnd(uint8_t code){
+      uint8_t frame[4] = {code, 0xFF, 0xFF, 0xFF};
+      _port.write(frame, 4);
+    }
+
+    virtual void run(){
+      while(_port.available() > 0){
+        take(_port.read());
+      }
+    }
+
+  protected:
+    HardwareSerial& _port;
+
+    void take(uint8_t c){                 // one byte, the command runs when its 0xFF 0xFF 0xFF is there
+      if(_rawLeft > 0){                   // the data of addt, 0xFF too
+        waveData.push_back(c);
+        if(--_rawLeft == 0) sendEnd(0xFD);
+        return;
+      }
+      if(c == 0xFF){
+        if(++_ends == 3){
+          commands.push_back(_command);
+          if(answer) runCommand(_command);
+          _command.clear();
+          _ends = 0;
+        }
+        return;
+      }
+      while(_ends > 0){                   // 0xFF inside a command
+        _command += (char)0xFF;
+        _ends--;
+      }
+      _command += (char)c;
+    }
+
+    void ok(){
+      if(bkcmd == 1 || bkcmd == 3) sendEnd(0x01);
+    }
+    void error(uint8_t code){
+      if(bkcmd >= 2) sendEnd(code);
+    }
+
+    virtual void runCommand(const std::string& command){
+      if(command.compare(0, 4, "get ") == 0){
+        std::string name = command.substr(4);
+        if(numbers.count(name) > 0){
+          uint32_t value = numbers[name];
+          uint8_t frame[8] = {0x71, (uint8_t)value, (uint8_t)(value >> 8), (uint8_t)(value >> 16),
+                              (uint8_t)(value >> 24), 0xFF, 0xFF, 0xFF};
+          _port.write(frame, 8);
+        }else if(texts.count(name) > 0){
+          _port.write(0x70);
+          _port.write((const uint8_t*)texts[name].data(), texts[name].size());
+          _port.write((const uint8_t*)"\xFF\xFF\xFF", 3);
+        }else{
+          error(0x1A);
+        }
+        return;
+      }
+      if(command.compare(0, 5, "addt ") == 0){
+        unsigned id = 0, channel = 0, count = 0;
+        sscanf(command.c_str() + 5, "%u,%u,%u", &id, &channel, &count);
+        if(std::find(waveIds.begin(), waveIds.end(), id) == waveIds.end()){
+          error(0x02);                    // invalid component id
+        }else{
+          _rawLeft = count;
+          sendEnd(0xFE);
+        }
+        return;
+      }
+      if(command == "sendme"){
+        uint8_t frame[5] = {0x66, page, 0xFF, 0xFF, 0xFF};
+        _port.write(frame, 5);
+        return;
+      }
+      size_t equal = command.find('=');
+      if(equal == std::string::npos){
+        ok();                             // any other instruction is taken as good
+        return;
+      }
+      std::string name = command.substr(0, equal);
+      std::string value = command.substr(equal + 1);
+      if(name == "bkcmd"){
+        bkcmd = atoi(value.c_str());
+        ok();
+      }else if(name == "baud"){
+        ok();
+        _port.begin(strtoul(value.c_str(), NULL, 10));  // the next bytes go at the new rate
+      }else if(name.compare(0, 3, "bad") == 0){
+        error(0x1A);
+      }else if(!value.empty() && value[0] == '"'){
+        texts[name] = value.substr(1, value.size() - 2);
+        ok();
+      }else{
+        numbers[name] = (uint32_t)strtol(value.c_str(), NULL, 10);
+        ok();
+      }
+    }
+
+  private:
+    std::string _command;
+    uint8_t _ends;
+    unsigned _rawLeft;                    // bytes of addt still to come
+    static testDisplay* _current;
+    static void tick(){
+      if(_current != NULL) _current->run();
+    }
+};
+
+testDisplay* testDisplay::_current = NULL;
+
+#endif
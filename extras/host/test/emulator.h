@@ -0,0 +1,119 @@
+/*
+ * emulator.h - the NextionEmulator example on the PC build, with the timing of a real Nextion
+ * All rights reserved under the library's licence
+ *
+ * It is a testDisplay (display.h) that does not run a command as soon as it arrives:
+ *   - the bytes go to an input buffer of inputSize (1024) bytes, like the one of Nextion.
+ *     When it is full the byte is lost and 0x24 is answered, once until it is half empty again
+ *   - each command takes execTime microseconds to run (500), the next one waits meanwhile
+ *   - "add" counts the value, "ref" is taken as good, "page n" loads page n (its components are loaded
+ *     again from the HMI and the event of its Preinitialize, printh 23 02 50 xx, is sent), other
+ *     instructions without '=' answer 0x00 (invalid instruction)
+ *   - with eventTime > 0, a touch event (printh 23 02 54 01) is sent every eventTime ms, and every
+ *     pageEvery events a page change instead. touch() and loadPage() send one at any time
+ */
+#ifndef emulator_h
+#define emulator_h
+
+#include <deque>
+#include "display.h"
+
+class testEmulator : public testDisplay {
+  public:
+    testEmulator(HardwareSerial& port) : testDisplay(port), inputSize(1024), execTime(500), eventTime(0),
+        pageEvery(10), pages(3), lostBytes(0), overflows(0), waveValues(0), _overflowSent(false),
+        _busyUntil(0), _lastEvent(0), _eventCount(0){
+    }
+
+    uint16_t inputSize;
+    unsigned long execTime;               // microseconds for each command
+    unsigned long eventTime;              // ms between touch events, 0 for none
+    uint16_t pageEvery;
+    uint8_t pages;
+    unsigned long lostBytes;              // bytes that found the input buffer full
+    unsigned long overflows;              // 0x24 sent
+    unsigned long waveValues;             // values of add, addt ones are in waveData
+
+    void touch(){
+      send({'#', 0x02, 'T', 0x01});
+    }
+    void loadPage(uint8_t number){
+      page = number;
+      numbers.clear();
+      texts.clear();
+      send({'#', 0x02, 'P', number});
+    }
+    size_t inputUsed() const { return _input.size(); }
+
+    void run(){
+      while(_port.available() > 0){       // from the Serial to the input buffer, like Nextion does
+        uint8_t c = _port.read();
+        if(_input.size() >= inputSize){
+          lostBytes++;
+          if(!_overflowSent){
+            sendEnd(0x24);                // serial buffer overflow
+            overflows++;
+            _overflowSent = true;
+          }
+          continue;
+        }
+        _input.push_back(c);
+      }
+
+      unsigned long now = micros();       // in the hook of the clock, it does not move it
+      while(!_input.empty() && (long)(now - _busyUntil) >= 0){
+        size_t count = commands.size();
+        take(_input.front());
+        _input.pop_front();
+        if(_input.size() < inputSize / 2){
+          _overflowSent = false;
+        }
+        if(commands.size() != count){
+          _busyUntil = now + execTime;    // a command ran, the next one waits
+        }
+      }
+
+      if(eventTime > 0 && millis() - _lastEvent >= eventTime){
+        _lastEvent = millis();
+        _eventCount++;
+        if(pageEvery > 0 && _eventCount % pageEvery == 0){
+          loadPage((page + 1) % pages);
+        }else{
+          touch();
+        }
+      }
+    }
+
+  protected:
+    void runCommand(const std::string& command){
+      if(command.compare(0, 4, "add ") == 0){
+        waveValues++;
+        ok();
+        return;
+      }
+      if(command.compare(0, 4, "ref ") == 0){
+        ok();
+        return;
+      }
+      if(command.compare(0, 5, "page ") == 0){
+        ok();
+        loadPage(atoi(command.c_str() + 5));
+        return;
+      }
+      if(command.find('=') == std::string::npos && command.compare(0, 4, "get ") != 0 &&
+         command.compare(0, 5, "addt ") != 0 && command != "sendme"){
+        error(0x00);                      // invalid instruction
+        return;
+      }
+      testDisplay::runCommand(command);
+    }
+
+  private:
+    std::deque<uint8_t> _input;
+    bool _overflowSent;
+    unsigned long _busyUntil;
+    unsigned long _lastEvent;
+    uint16_t _eventCount;
+};
+
+#endif
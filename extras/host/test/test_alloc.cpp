@@ -0,0 +1,93 @@
+/*
+ * test_alloc.cpp - the writes with char arrays, F() texts, handles and String never use the heap
+ * All rights reserved under the library's licence
+ *
+ * The global operator new of this program counts every allocation (the String of the
+ * PC build takes its memory with new[], like malloc() on a board).
+ */
+
+#include <cstdlib>
+#include <new>
+#include "check.h"
+#include "display.h"
+#include "nextion_ez.h"
+
+static long allocations;
+
+void* operator new(size_t size){
+  allocations++;
+  void* p = malloc(size ? size : 1);
+  if(p == NULL) throw std::bad_alloc();
+  return p;
+}
+void* operator new[](size_t size){
+  allocations++;
+  void* p = malloc(size ? size : 1);
+  if(p == NULL) throw std::bad_alloc();
+  return p;
+}
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+
+NEX_COMPONENT(speed, "n0.val");
+
+static void setup(nextion_ez& myNex){
+  Serial1.connect(Serial2);
+  Serial1.begin(115200);
+  myNex.begin(115200);
+}
+
+static void writesDoNotAllocate(){        // 100 rounds of every write, as a dashboard refresh does
+  testDisplay display(Serial1);
+  display.commands.reserve(2000);         // the fake display must not count either
+  nextion_ez myNex(Serial2);
+  setup(myNex);
+  String name("n1.val");
+  String text("hello");
+  const char label[] = "label text";
+  long before = 0;
+  for(uint32_t i = 0; i < 101; i++){
+    if(i == 1){
+      delay(10);                          // the first round fills the tables of the fake display
+      before = allocations;
+    }
+    myNex.writeNum("n0.val", i);
+    myNex.writeNum(F("n0.val"), i);
+    myNex.writeNum(speed, i);
+    myNex.writeNum(name, i);
+    myNex.writeInt("n2.val", -(int32_t)i);
+    myNex.writeStr("t0.txt", "hello");
+    myNex.writeStr("t0.txt", label, 5);
+    myNex.writeStr(F("t0.txt"), F("hello"));
+    myNex.writeStr(name, text);
+    myNex.sendCmd("page 0");
+    myNex.sendCmd(F("ref t0"));
+    myNex.listen();
+  }
+  CHECK_EQUAL(0, allocations - before);
+}
+
+static void readsDoNotAllocate(){         // the numbers only, readStr(String) returns a String by design
+  testDisplay display(Serial1);
+  display.commands.reserve(200);
+  display.numbers["n0.val"] = 5;
+  nextion_ez myNex(Serial2);
+  setup(myNex);
+  char buffer[16];
+  display.texts["t0.txt"] = "abc";
+  long before = allocations;
+  for(int i = 0; i < 20; i++){
+    CHECK_EQUAL(5, myNex.readNum("n0.val"));
+    CHECK_EQUAL(5, myNex.readNum(speed));
+    CHECK_EQUAL(3, myNex.readStr("t0.txt", buffer, sizeof(buffer)));
+  }
+  CHECK_EQUAL(0, allocations - before);
+}
+
+int main(){
+  RUN(writesDoNotAllocate);
+  RUN(readsDoNotAllocate);
+  return CHECK_RESULT();
+}
@@ -0,0 +1,62 @@
+/*
+ * test_baud.cpp - beginAuto() finds the baud rate of Nextion and moves both sides to a faster one
+ * All rights reserved under the library's licence
+ */
+
+#include "check.h"
+#include "display.h"
+#include "nextion_ez.h"
+
+static void findsAndUpgrades(){           // Nextion at 38400, 115200 asked
+  Serial1.connect(Serial2);
+  Serial1.begin(38400);
+  testDisplay display(Serial1);
+  nextion_ez myNex(Serial2);
+  CHECK_EQUAL(115200, myNex.beginAuto(115200));
+  CHECK_EQUAL(115200, Serial1.baud());
+  CHECK_EQUAL(115200, Serial2.baud());
+}
+
+static void onlyRatesOfNextion(){         // 100000 is not a rate of Nextion, the fastest below it is used
+  Serial1.connect(Serial2);
+  Serial1.begin(9600);
+  testDisplay display(Serial1);
+  nextion_ez myNex(Serial2);
+  CHECK_EQUAL(57600, myNex.beginAuto(100000));
+  CHECK_EQUAL(57600, Serial1.baud());
+  CHECK(display.commands.back() == "sendme");
+  bool sent = false;
+  for(size_t i = 0; i < display.commands.size(); i++){
+    if(display.commands[i] == "baud=57600") sent = true;
+    CHECK(display.commands[i] != "baud=100000");
+  }
+  CHECK(sent);
+}
+
+static void alreadyFastEnough(){          // no "baud=" when Nextion is at the rate asked or above
+  Serial1.connect(Serial2);
+  Serial1.begin(115200);
+  testDisplay display(Serial1);
+  nextion_ez myNex(Serial2);
+  CHECK_EQUAL(115200, myNex.beginAuto(115200));
+  for(size_t i = 0; i < display.commands.size(); i++){
+    CHECK(display.commands[i].compare(0, 5, "baud=") != 0);
+  }
+}
+
+static void noNextion(){
+  Serial1.connect(Serial2);
+  Serial1.begin(9600);
+  testDisplay display(Serial1);
+  display.answer = false;
+  nextion_ez myNex(Serial2);
+  CHECK_EQUAL(0, myNex.beginAuto(115200));
+}
+
+int main(){
+  RUN(findsAndUpgrades);
+  RUN(onlyRatesOfNextion);
+  RUN(alreadyFastEnough);
+  RUN(noNextion);
+  return CHECK_RESULT();
+}
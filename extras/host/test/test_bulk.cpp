@@ -0,0 +1,61 @@
+/*
+ * test_bulk.cpp - the queue of setPriority(NEX_PRIO_BULK), built with NEXTION_EZ_STATS 1
+ * All rights reserved under the library's licence
+ */
+
+#include "check.h"
+#include "display.h"
+#include "nextion_ez.h"
+
+static void setup(nextion_ez& myNex){
+  Serial1.connect(Serial2);
+  Serial1.begin(115200);
+  myNex.begin(115200);
+}
+
+static void listenFor(nextion_ez& myNex, unsigned long ms){
+  unsigned long start = millis();
+  while(millis() - start < ms){
+    myNex.listen();
+  }
+}
+
+static void fullQueueDoesNotWait(){       // without listen() the queue never empties, the write goes at once
+  testDisplay display(Serial1);
+  display.answer = false;
+  nextion_ez myNex(Serial2);
+  setup(myNex);
+  myNex.useFlowControl(true);             // never answered, listen() could not send the queue anyway
+  myNex.setPriority(NEX_PRIO_BULK);
+  unsigned long start = millis();
+  char name[8] = "t0.txt";
+  for(int i = 0; i < 8; i++){
+    name[1] = '0' + i;
+    myNex.writeStr(name, "0123456789");
+  }
+  CHECK(millis() - start < 20);
+  CHECK(myNex.getStats().bulkFull > 0);
+  CHECK(myNex.pendingBulk() <= NEXTION_EZ_BULK_SIZE);
+  delay(10);
+  CHECK_EQUAL(1 + myNex.getStats().bulkFull, display.commands.size());  // bkcmd=3 and the ones sent at once
+}
+
+static void olderValuesMakeRoom(){        // a newer value of the same component takes the room of the older one
+  testDisplay display(Serial1);
+  nextion_ez myNex(Serial2);
+  setup(myNex);
+  myNex.setPriority(NEX_PRIO_BULK);
+  for(uint32_t i = 0; i < 100; i++){
+    myNex.writeNum("n0.val", i);
+  }
+  CHECK_EQUAL(0, myNex.getStats().bulkFull);
+  listenFor(myNex, 10);
+  CHECK_EQUAL(1, display.commands.size());
+  CHECK(display.commands[0] == "n0.val=99");
+}
+
+int main(){
+  RUN(fullQueueDoesNotWait);
+  RUN(olderValuesMakeRoom);
+  return CHECK_RESULT();
+}
@@ -0,0 +1,155 @@
+/*
+ * test_cache.cpp - useCache(): a value is remembered only once it is sent, and forgotten when it fails
+ * All rights reserved under the library's licence
+ */
+
+#include <string>
+#include "check.h"
+#include "display.h"
+#include "nextion_ez.h"
+
+static void setup(nextion_ez& myNex){
+  Serial1.connect(Serial2);
+  Serial1.begin(115200);
+  myNex.begin(115200);
+  myNex.useCache(true);
+}
+
+static void listenFor(nextion_ez& myNex, unsigned long ms){
+  unsigned long start = millis();
+  while(millis() - start < ms){
+    myNex.listen();
+  }
+}
+
+static int seen(const testDisplay& display, const std::string& command){
+  int count = 0;
+  for(const std::string& c : display.commands){
+    if(c == command) count++;
+  }
+  return count;
+}
+
+static void sameValueIsNotSent(){
+  testDisplay display(Serial1);
+  nextion_ez myNex(Serial2);
+  setup(myNex);
+  myNex.writeNum("n0.val", 5);
+  myNex.writeNum("n0.val", 5);
+  myNex.writeStr("t0.txt", "ab");
+  myNex.writeStr("t0.txt", "ab");
+  listenFor(myNex, 5);
+  CHECK_EQUAL(1, seen(display, "n0.val=5"));
+  CHECK_EQUAL(1, seen(display, "t0.txt=\"ab\""));
+  display.send({'#', 0x02, 'P', 0x01});   // a new page shows the values of the HMI file
+  listenFor(myNex, 5);
+  myNex.writeNum("n0.val", 5);
+  listenFor(myNex, 5);
+  CHECK_EQUAL(2, seen(display, "n0.val=5"));
+}
+
+static void rejectedWriteIsSentAgain(){   // without flow control the failed write is not known, all are forgotten
+  testDisplay display(Serial1);
+  nextion_ez myNex(Serial2);
+  setup(myNex);
+  myNex.writeNum("n0.val", 1);
+  myNex.writeNum("bad0.val", 1);
+  listenFor(myNex, 5);
+  CHECK_EQUAL(0x1A, myNex.getLastError());
+  myNex.writeNum("bad0.val", 1);
+  myNex.writeNum("n0.val", 1);
+  listenFor(myNex, 5);
+  CHECK_EQUAL(2, seen(display, "bad0.val=1"));
+  CHECK_EQUAL(2, seen(display, "n0.val=1"));
+}
+
+static void flowControlForgetsOnlyTheFailed(){
+  testDisplay display(Serial1);
+  nextion_ez myNex(Serial2);
+  setup(myNex);
+  myNex.useFlowControl(true);
+  myNex.writeNum("n0.val", 1);
+  myNex.writeNum("bad0.val", 1);
+  listenFor(myNex, 5);
+  CHECK_EQUAL(0, myNex.pendingCommands());
+  myNex.writeNum("bad0.val", 1);
+  myNex.writeNum("n0.val", 1);
+  listenFor(myNex, 5);
+  CHECK_EQUAL(2, seen(display, "bad0.val=1"));
+  CHECK_EQUAL(1, seen(display, "n0.val=1"));
+}
+
+static void unansweredWriteIsSentAgain(){ // with flow control, a write with no answer may be lost
+  testDisplay display(Serial1);
+  nextion_ez myNex(Serial2);
+  setup(myNex);
+  myNex.useFlowControl(true);
+  listenFor(myNex, 5);
+  myNex.setRequestTimeout(50);
+  display.answer = false;
+  myNex.writeNum("n0.val", 1);
+  listenFor(myNex, 60);
+  display.answer = true;
+  myNex.writeNum("n0.val", 1);
+  listenFor(myNex, 5);
+  CHECK_EQUAL(2, seen(display, "n0.val=1"));
+}
+
+static void heldWriteCountsWhenSent(){    // a value waiting in a batch or in the bulk queue is not sent twice
+  testDisplay display(Serial1);
+  nextion_ez myNex(Serial2);
+  setup(myNex);
+  myNex.beginBatch();
+  myNex.writeNum("n0.val", 1);
+  myNex.writeNum("n0.val", 1);
+  myNex.flush();
+  myNex.setPriority(NEX_PRIO_BULK);
+  myNex.writeNum("n1.val", 1);
+  myNex.writeNum("n1.val", 1);
+  myNex.setPriority(NEX_PRIO_HIGH);
+  listenFor(myNex, 5);
+  CHECK_EQUAL(1, seen(display, "n0.val=1"));
+  CHECK_EQUAL(1, seen(display, "n1.val=1"));
+}
+
+static void replacedBulkWriteIsForgotten(){  // the newer value replaces the queued one, in the cache too
+  testDisplay display(Serial1);
+  nextion_ez myNex(Serial2);
+  setup(myNex);
+  myNex.setPriority(NEX_PRIO_BULK);
+  myNex.writeNum("n0.val", 1);
+  myNex.setPriority(NEX_PRIO_HIGH);
+  myNex.writeNum("n0.val", 2);            // the 1 in the queue is never sent
+  myNex.writeNum("n0.val", 1);
+  listenFor(myNex, 5);
+  CHECK_EQUAL(1, seen(display, "n0.val=1"));
+  CHECK_EQUAL(1, seen(display, "n0.val=2"));
+  CHECK_EQUAL(1, display.numbers["n0.val"]);
+}
+
+static void deferredWriteIsSentLater(){   // while Nextion sleeps the value is kept, not cached
+  testDisplay display(Serial1);
+  nextion_ez myNex(Serial2);
+  setup(myNex);
+  myNex.writeNum("n0.val", 1);
+  display.send({0x86, 0xFF, 0xFF, 0xFF});
+  listenFor(myNex, 5);
+  myNex.writeNum("n0.val", 2);
+  display.send({0x87, 0xFF, 0xFF, 0xFF});
+  listenFor(myNex, 5);
+  myNex.writeNum("n0.val", 2);
+  listenFor(myNex, 5);
+  CHECK_EQUAL(1, seen(display, "n0.val=2"));
+  CHECK_EQUAL(2, display.numbers["n0.val"]);
+}
+
+int main(){
+  RUN(sameValueIsNotSent);
+  RUN(rejectedWriteIsSentAgain);
+  RUN(flowControlForgetsOnlyTheFailed);
+  RUN(unansweredWriteIsSentAgain);
+  RUN(heldWriteCountsWhenSent);
+  RUN(replacedBulkWriteIsForgotten);
+  RUN(deferredWriteIsSentLater);
+  return CHECK_RESULT();
+}
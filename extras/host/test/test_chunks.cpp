@@ -0,0 +1,88 @@
+/*
+ * test_chunks.cpp - readStr() into a char array and in parts, built with NEXTION_EZ_STR_MAX 8
+ * All rights reserved under the library's licence
+ */
+
+#include <string>
+#include <vector>
+#include "check.h"
+#include "display.h"
+#include "nextion_ez.h"
+
+static std::vector<std::string> parts;
+
+static void takePart(const char* part, uint8_t length){
+  parts.push_back(std::string(part, length));
+}
+
+static void setup(nextion_ez& myNex){
+  Serial1.connect(Serial2);
+  Serial1.begin(115200);
+  myNex.begin(115200);
+  parts.clear();
+}
+
+static std::string joined(){
+  std::string text;
+  for(const std::string& part : parts) text += part;
+  return text;
+}
+
+static void longTextInParts(){
+  testDisplay display(Serial1);
+  display.texts["t0.txt"] = "abcdefghijklmnopqrstu";
+  nextion_ez myNex(Serial2);
+  setup(myNex);
+  CHECK_EQUAL(NEX_OK, myNex.readStr("t0.txt", takePart));
+  CHECK_EQUAL(3, parts.size());
+  CHECK(parts[0] == "abcdefgh");
+  CHECK(parts[2] == "qrstu");
+  CHECK(joined() == "abcdefghijklmnopqrstu");
+}
+
+static void textLongerThanAFrameCount(){  // more than 255 characters, a whole number of parts
+  testDisplay display(Serial1);
+  std::string text;
+  for(int i = 0; i < 320; i++) text += (char)('a' + i % 26);
+  display.texts["t0.txt"] = text;
+  Serial1.setBuffers(64, 512);            // the reply is written at once, it must not wait in the hook of the clock
+  nextion_ez myNex(Serial2);
+  setup(myNex);
+  CHECK_EQUAL(NEX_OK, myNex.readStr("t0.txt", takePart));
+  CHECK_EQUAL(40, parts.size());
+  CHECK(joined() == text);
+  Serial1.setBuffers(64, 64);
+}
+
+static void emptyAndWrongName(){
+  testDisplay display(Serial1);
+  display.texts["t0.txt"] = "";
+  nextion_ez myNex(Serial2);
+  setup(myNex);
+  CHECK_EQUAL(NEX_OK, myNex.readStr("t0.txt", takePart));
+  CHECK(joined() == "");
+  CHECK_EQUAL(NEX_ERROR, myNex.readStr("t9.txt", takePart));
+  CHECK_EQUAL(0x1A, myNex.getLastError());
+  myNex.writeNum("n0.val", 1);            // the next reply is not taken as a part
+  CHECK(joined() == "");
+}
+
+static void charArrayIsCut(){             // the length of the whole text is returned
+  testDisplay display(Serial1);
+  display.texts["t0.txt"] = "abcdefghijkl";
+  nextion_ez myNex(Serial2);
+  setup(myNex);
+  char buffer[6];
+  CHECK_EQUAL(12, myNex.readStr("t0.txt", buffer, sizeof(buffer)));
+  CHECK(std::string(buffer) == "abcde");
+  CHECK_EQUAL(-1, myNex.readStr("t9.txt", buffer, sizeof(buffer)));
+  CHECK_EQUAL(0, buffer[0]);
+}
+
+int main(){
+  RUN(longTextInParts);
+  RUN(textLongerThanAFrameCount);
+  RUN(emptyAndWrongName);
+  RUN(charArrayIsCut);
+  return CHECK_RESULT();
+}
@@ -0,0 +1,123 @@
+/*
+ * test_commands.cpp - the custom commands of cmdAvail(), getCmdLen() and readByte()
+ * Built twice: with the default options and with NEXTION_EZ_CMD_MAX 255 and NEXTION_EZ_NATIVE_EVENTS 1
+ * All rights reserved under the library's licence
+ */
+
+#include <cstring>
+#include <new>
+#include "check.h"
+#include "display.h"
+#include "nextion_ez.h"
+
+static int touchCount;
+
+static void setup(nextion_ez& myNex){
+  Serial1.connect(Serial2);
+  Serial1.begin(115200);
+  myNex.begin(115200);
+}
+
+static void listenFor(nextion_ez& myNex, unsigned long ms){
+  unsigned long start = millis();
+  while(millis() - start < ms){
+    myNex.listen();
+  }
+}
+
+static void longCommandIsCut(){           // the bytes past NEXTION_EZ_CMD_MAX are skipped, the next frame is kept
+  const int kept = (20 < NEXTION_EZ_CMD_MAX) ? 20 : NEXTION_EZ_CMD_MAX;
+  testDisplay display(Serial1);
+  nextion_ez myNex(Serial2);
+  setup(myNex);
+  std::vector<uint8_t> frame = {'#', 20, 'L'};
+  for(uint8_t i = 1; i < 20; i++){
+    frame.push_back(i);
+  }
+  display.send(frame);
+  display.send({'#', 0x02, 'P', 0x03});
+  listenFor(myNex, 5);
+  CHECK(myNex.cmdAvail());
+  CHECK_EQUAL('L', myNex.getCmd());
+  CHECK_EQUAL(kept, myNex.getCmdLen());
+  for(int i = 1; i < kept; i++){
+    CHECK_EQUAL(i, myNex.readByte());
+  }
+  CHECK_EQUAL(-1, myNex.readByte());
+  CHECK_EQUAL(3, myNex.getCurrentPage());
+}
+
+static void readByteDoesNotReadTheSerial(){
+  testDisplay display(Serial1);
+  nextion_ez myNex(Serial2);
+  setup(myNex);
+  display.send({'#', 0x02, 'T', 0x01});
+  listenFor(myNex, 5);
+  display.send({'#', 0x02, 'T', 0x02});
+  delay(5);                               // the second command waits in the Serial
+  CHECK(myNex.cmdAvail());
+  CHECK_EQUAL(2, myNex.getCmdLen());
+  CHECK_EQUAL(1, myNex.readByte());
+  CHECK_EQUAL(-1, myNex.readByte());
+  CHECK_EQUAL(-1, myNex.readByte());
+  listenFor(myNex, 5);
+  CHECK(myNex.cmdAvail());
+  CHECK_EQUAL('T', myNex.getCmd());
+  CHECK_EQUAL(2, myNex.readByte());
+}
+
+static void touched(uint8_t, const uint8_t*, uint8_t){
+  touchCount++;
+}
+
+static void nativeFramesAreOptIn(){       // touch and sleep frames are commands only with NEXTION_EZ_NATIVE_EVENTS 1
+  testDisplay display(Serial1);
+  nextion_ez myNex(Serial2);
+  setup(myNex);
+  display.send({0x65, 0x00, 0x03, 0x01, 0xFF, 0xFF, 0xFF});
+  display.send({0x86, 0xFF, 0xFF, 0xFF});
+  display.send({'#', 0x02, 'T', 0x01});
+  listenFor(myNex, 5);
+  CHECK(myNex.isAsleep());                // the sleep is seen either way
+  CHECK(myNex.cmdAvail());
+#if NEXTION_EZ_NATIVE_EVENTS
+  CHECK_EQUAL(0x65, myNex.getCmd());
+  CHECK_EQUAL(0, myNex.readByte());
+  CHECK_EQUAL(3, myNex.readByte());
+  CHECK(myNex.cmdAvail());
+  CHECK_EQUAL(0x86, myNex.getCmd());
+  CHECK(myNex.cmdAvail());
+#endif
+  CHECK_EQUAL('T', myNex.getCmd());
+  CHECK(!myNex.cmdAvail());
+
+  touchCount = 0;
+  myNex.onCommand(0x65, touched);
+  display.send({0x65, 0x00, 0x03, 0x01, 0xFF, 0xFF, 0xFF});
+  listenFor(myNex, 5);
+  CHECK_EQUAL(NEXTION_EZ_NATIVE_EVENTS ? 1 : 0, touchCount);
+  CHECK(!myNex.cmdAvail());
+}
+
+static void pageBeforeTheFirstFrame(){    // page 0 until Nextion tells, whatever was in the memory before
+  testDisplay display(Serial1);
+  alignas(nextion_ez) static uint8_t memory[sizeof(nextion_ez)];
+  memset(memory, 0xA5, sizeof(memory));
+  nextion_ez* myNex = new(memory) nextion_ez(Serial2);
+  setup(*myNex);
+  CHECK_EQUAL(0, myNex->getCurrentPage());
+  CHECK_EQUAL(0, myNex->getLastPage());
+  display.send({'#', 0x02, 'P', 0x02});
+  listenFor(*myNex, 5);
+  CHECK_EQUAL(2, myNex->getCurrentPage());
+  CHECK_EQUAL(0, myNex->getLastPage());
+  myNex->~nextion_ez();
+}
+
+int main(){
+  RUN(longCommandIsCut);
+  RUN(readByteDoesNotReadTheSerial);
+  RUN(nativeFramesAreOptIn);
+  RUN(pageBeforeTheFirstFrame);
+  return CHECK_RESULT();
+}
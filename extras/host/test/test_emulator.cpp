@@ -0,0 +1,126 @@
+/*
+ * test_emulator.cpp - the emulator of emulator.h: its run time, its 1024 byte buffer and its events
+ * All rights reserved under the library's licence
+ */
+
+#include "check.h"
+#include "emulator.h"
+#include "nextion_ez.h"
+
+static uint8_t lastStatus;
+
+static void commandDone(uint16_t, uint8_t status){
+  lastStatus = status;
+}
+
+static void setup(nextion_ez& myNex, unsigned long baud){
+  Serial1.connect(Serial2);
+  Serial1.begin(baud);
+  myNex.begin(baud);
+}
+
+static void listenFor(nextion_ez& myNex, unsigned long ms){
+  unsigned long start = millis();
+  while(millis() - start < ms){
+    myNex.listen();
+  }
+}
+
+static void commandsTakeTheirTime(){      // 1ms each, the bytes arrive much faster
+  testEmulator nextion(Serial1);
+  nextion.execTime = 1000;
+  nextion_ez myNex(Serial2);
+  setup(myNex, 921600);
+  for(uint32_t i = 0; i < 10; i++){
+    myNex.writeNum("n0.val", i);
+  }
+  delay(3);
+  CHECK(nextion.commands.size() >= 2 && nextion.commands.size() <= 4);
+  delay(10);
+  CHECK_EQUAL(10, nextion.commands.size());
+  CHECK_EQUAL(9, nextion.numbers["n0.val"]);
+}
+
+static void fullBufferAnswers0x24(){
+  testEmulator nextion(Serial1);
+  nextion.execTime = 20000;
+  nextion_ez myNex(Serial2);
+  setup(myNex, 115200);
+  for(uint32_t i = 0; i < 100; i++){
+    myNex.writeNum("n0.val", 10000 + i);  // 15 bytes each, 1500 in all
+  }
+  listenFor(myNex, 20);
+  CHECK_EQUAL(0x24, myNex.getLastError());
+  CHECK_EQUAL(1, nextion.overflows);
+  CHECK(nextion.lostBytes > 300);
+  CHECK(nextion.inputUsed() > 1000);
+}
+
+static void flowControlNeverOverflows(){
+  testEmulator nextion(Serial1);
+  nextion.execTime = 2000;
+  nextion_ez myNex(Serial2);
+  setup(myNex, 115200);
+  myNex.useFlowControl(true);
+  for(uint32_t i = 0; i < 100; i++){
+    myNex.writeNum("n0.val", 10000 + i);
+  }
+  unsigned long start = millis();
+  while(myNex.pendingCommands() > 0 && millis() - start < 1000){
+    myNex.listen();
+  }
+  CHECK_EQUAL(0, nextion.overflows);
+  CHECK_EQUAL(101, nextion.commands.size());  // bkcmd=3 and the writes
+  CHECK_EQUAL(10099, nextion.numbers["n0.val"]);
+}
+
+static void eventsAreSent(){              // at once, then every 10ms, each third one a page change
+  testEmulator nextion(Serial1);
+  nextion_ez myNex(Serial2);
+  setup(myNex, 115200);
+  nextion.pageEvery = 3;
+  nextion.eventTime = 10;
+  int touches = 0;
+  unsigned long start = millis();
+  while(millis() - start < 65){
+    myNex.listen();
+    while(myNex.cmdAvail()){
+      if(myNex.getCmd() == 'T') touches++;
+    }
+  }
+  CHECK_EQUAL(5, touches);
+  CHECK_EQUAL(2, myNex.getCurrentPage());
+  nextion.touch();
+  listenFor(myNex, 2);
+  CHECK(myNex.cmdAvail());
+}
+
+static void pageAndWrongInstruction(){
+  testEmulator nextion(Serial1);
+  nextion.numbers["n0.val"] = 5;
+  nextion_ez myNex(Serial2);
+  setup(myNex, 115200);
+  myNex.useFlowControl(true);
+  myNex.setCommandCallback(commandDone);
+  myNex.sendCmd("page 2");
+  listenFor(myNex, 5);
+  CHECK_EQUAL(NEX_OK, lastStatus);
+  CHECK_EQUAL(2, myNex.getCurrentPage());
+  CHECK_EQUAL(0, nextion.numbers.count("n0.val"));  // loaded again from the HMI
+  myNex.sendCmd("ref 0");
+  listenFor(myNex, 5);
+  CHECK_EQUAL(NEX_OK, lastStatus);
+  myNex.sendCmd("refresh 0");
+  listenFor(myNex, 5);
+  CHECK_EQUAL(NEX_ERROR, lastStatus);
+  CHECK_EQUAL(0x00, myNex.getLastError());
+}
+
+int main(){
+  RUN(commandsTakeTheirTime);
+  RUN(fullBufferAnswers0x24);
+  RUN(flowControlNeverOverflows);
+  RUN(eventsAreSent);
+  RUN(pageAndWrongInstruction);
+  return CHECK_RESULT();
+}
@@ -0,0 +1,89 @@
+/*
+ * test_flow.cpp - the window of useFlowControl()
+ * All rights reserved under the library's licence
+ */
+
+#include "check.h"
+#include "display.h"
+#include "nextion_ez.h"
+
+static testDisplay* display;
+static size_t seenAtFirstAnswer;
+
+static void commandDone(uint16_t, uint8_t){
+  if(seenAtFirstAnswer == 0){
+    seenAtFirstAnswer = display->commands.size();
+  }
+}
+
+static void setup(nextion_ez& myNex){
+  Serial1.connect(Serial2);
+  Serial1.begin(115200);
+  myNex.begin(115200);
+  myNex.useFlowControl(true);
+  unsigned long start = millis();
+  while(myNex.pendingCommands() > 0 && millis() - start < 50){
+    myNex.listen();                       // the answer of bkcmd=3
+  }
+  seenAtFirstAnswer = 0;
+}
+
+static void waitsBeforeSending(){         // a full window keeps the new command until an answer comes
+  testDisplay nextion(Serial1);
+  display = &nextion;
+  nextion_ez myNex(Serial2);
+  setup(myNex);
+  nextion.answer = false;
+  myNex.setFlowWindow(2, 512);
+  myNex.setRequestTimeout(50);
+  myNex.setCommandCallback(commandDone);
+  myNex.writeNum("n0.val", 1);
+  myNex.writeNum("n1.val", 2);
+  myNex.writeNum("n2.val", 3);            // waits for the timeout of n0.val
+  delay(5);
+  CHECK_EQUAL(3, seenAtFirstAnswer);      // bkcmd=3 and the first two
+  CHECK_EQUAL(4, nextion.commands.size());
+  CHECK(nextion.commands[3] == "n2.val=3");
+}
+
+static void batchIsKept(){                // beginBatch() holds the commands while the window has room
+  testDisplay nextion(Serial1);
+  display = &nextion;
+  nextion_ez myNex(Serial2);
+  setup(myNex);
+  myNex.beginBatch();
+  myNex.writeNum("n0.val", 1);
+  myNex.writeNum("n1.val", 2);
+  delay(5);
+  CHECK_EQUAL(1, nextion.commands.size());
+  myNex.flush();
+  delay(5);
+  CHECK_EQUAL(3, nextion.commands.size());
+}
+
+static void fullBatchIsSent(){            // the held commands must go, or their answers never come
+  testDisplay nextion(Serial1);
+  display = &nextion;
+  nextion_ez myNex(Serial2);
+  setup(myNex);
+  myNex.setFlowWindow(2, 512);
+  myNex.beginBatch();
+  for(uint32_t i = 0; i < 5; i++){
+    myNex.writeNum("n0.val", i);
+  }
+  myNex.flush();
+  unsigned long start = millis();
+  while(myNex.pendingCommands() > 0 && millis() - start < 50){
+    myNex.listen();
+  }
+  CHECK_EQUAL(6, nextion.commands.size());
+  CHECK(nextion.commands[5] == "n0.val=4");
+  CHECK_EQUAL(0, myNex.getStats().flowTimeouts);
+}
+
+int main(){
+  RUN(waitsBeforeSending);
+  RUN(batchIsKept);
+  RUN(fullBatchIsSent);
+  return CHECK_RESULT();
+}
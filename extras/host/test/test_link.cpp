@@ -0,0 +1,145 @@
+/*
+ * test_link.cpp - the Serial stand-in of the PC build, and nextion_ez running on it
+ * All rights reserved under the library's licence
+ */
+
+#include "check.h"
+#include "display.h"
+#include "nextion_ez.h"
+
+static void loopbackPacing(){             // 9600 baud: about 1.04ms for each byte
+  Serial1.begin(9600);
+  Serial1.write((const uint8_t*)"0123456789", 10);
+  CHECK_EQUAL(0, Serial1.available());
+  delay(5);
+  CHECK(Serial1.available() >= 4 && Serial1.available() <= 5);
+  delay(6);
+  CHECK_EQUAL(10, Serial1.available());
+  CHECK_EQUAL('0', Serial1.read());
+}
+
+static void connectedPorts(){
+  Serial1.connect(Serial2);
+  Serial1.begin(115200);
+  Serial2.begin(115200);
+  Serial1.write('a');
+  Serial2.write('b');
+  delay(1);
+  CHECK_EQUAL('b', Serial1.read());
+  CHECK_EQUAL('a', Serial2.read());
+  CHECK_EQUAL(-1, Serial1.read());
+}
+
+static void wrongBaudIsLost(){
+  Serial1.connect(Serial2);
+  Serial1.begin(9600);
+  Serial2.begin(115200);
+  Serial1.write('a');
+  delay(2);
+  CHECK_EQUAL(0, Serial2.available());
+  CHECK_EQUAL(1, Serial2.lostBytes());
+}
+
+static void fullRingOverruns(){           // the receive ring keeps 64 bytes, like the core of an Uno
+  Serial1.begin(115200);
+  for(int i = 0; i < 100; i++){
+    Serial1.write((uint8_t)i);
+  }
+  delay(10);
+  CHECK_EQUAL(64, Serial1.available());
+  CHECK_EQUAL(36, Serial1.lostBytes());
+}
+
+static void writeBlocksWhenFull(){        // a full transmit ring waits for the wire, the clock moves meanwhile
+  Serial1.begin(9600);
+  unsigned long start = micros();
+  for(int i = 0; i < 74; i++){
+    Serial1.write('x');
+  }
+  unsigned long time = micros() - start;
+  CHECK(time >= 9000 && time < 12000);    // 10 bytes had to leave first
+}
+
+static void writeNumOnTheWire(){
+  Serial1.connect(Serial2);
+  Serial1.begin(9600);
+  testDisplay display(Serial1);
+  nextion_ez myNex(Serial2);
+  myNex.begin(9600);
+  myNex.writeNum("n0.val", 765);
+  myNex.writeStr("t0.txt", "Hello");
+  delay(50);
+  CHECK_EQUAL(2, display.commands.size());
+  CHECK(display.commands[0] == "n0.val=765");
+  CHECK(display.commands[1] == "t0.txt=\"Hello\"");
+  CHECK_EQUAL(765, display.numbers["n0.val"]);
+}
+
+static void readNumRoundTrip(){
+  Serial1.connect(Serial2);
+  Serial1.begin(115200);
+  testDisplay display(Serial1);
+  display.numbers["n0.val"] = 42;
+  display.texts["t0.txt"] = "abc";
+  nextion_ez myNex(Serial2);
+  myNex.begin(115200);
+  CHECK_EQUAL(42, myNex.readNum("n0.val"));
+  CHECK(myNex.readStr("t0.txt") == "abc");
+  CHECK_EQUAL(777777, myNex.readNum("x9.val"));   // 0x1A
+}
+
+static void listenTakesEvents(){
+  Serial1.connect(Serial2);
+  Serial1.begin(9600);
+  testDisplay display(Serial1);
+  nextion_ez myNex(Serial2);
+  myNex.begin(9600);
+  display.send({'#', 0x02, 'P', 0x03, '#', 0x03, 'T', 0x01, 0x02});
+  for(int i = 0; i < 20; i++){
+    delay(1);
+    myNex.listen();
+  }
+  CHECK_EQUAL(3, myNex.getCurrentPage());
+  CHECK(myNex.cmdAvail());
+  CHECK_EQUAL('T', myNex.getCmd());
+  CHECK_EQUAL(1, myNex.readByte());
+  CHECK_EQUAL(2, myNex.readByte());
+}
+
+NEX_COMPONENT(speed, "n0.val");
+
+static void optionsOffByDefault(){       // without their sizes, the optional features send as a plain write
+  Serial1.connect(Serial2);
+  Serial1.begin(115200);
+  testDisplay display(Serial1);
+  nextion_ez myNex(Serial2);
+  myNex.begin(115200);
+  CHECK(!myNex.onPage(speed, 1));
+  myNex.useFlowControl(true);
+  myNex.useCache(true);
+  myNex.writeNum("n1.val", 5);
+  myNex.writeNum("n1.val", 5);
+  myNex.setPriority(NEX_PRIO_BULK);
+  myNex.writeNum("n2.val", 6);
+  CHECK_EQUAL(0, myNex.pendingBulk());
+  myNex.streamWave(1, 0, 7);
+  delay(5);
+  CHECK_EQUAL(4, display.commands.size());
+  CHECK(display.commands[0] == "n1.val=5");
+  CHECK(display.commands[2] == "n2.val=6");
+  CHECK(display.commands[3] == "add 1,0,7");
+  CHECK_EQUAL(0, myNex.pendingCommands());
+}
+
+int main(){
+  RUN(loopbackPacing);
+  RUN(connectedPorts);
+  RUN(wrongBaudIsLost);
+  RUN(fullRingOverruns);
+  RUN(writeBlocksWhenFull);
+  RUN(writeNumOnTheWire);
+  RUN(readNumRoundTrip);
+  RUN(listenTakesEvents);
+  RUN(optionsOffByDefault);
+  return CHECK_RESULT();
+}
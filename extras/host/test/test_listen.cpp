@@ -0,0 +1,114 @@
+/*
+ * test_listen.cpp - the frame parser of listen(), built with NEXTION_EZ_STATS 1 and NEXTION_EZ_NATIVE_EVENTS 1
+ * All rights reserved under the library's licence
+ */
+
+#include "check.h"
+#include "display.h"
+#include "nextion_ez.h"
+
+static nextion_ez* nex;
+static uint32_t nestedValue;
+
+static void setup(nextion_ez& myNex){
+  Serial1.connect(Serial2);
+  Serial1.begin(115200);
+  myNex.begin(115200);
+  nex = &myNex;
+}
+
+static void listenFor(nextion_ez& myNex, unsigned long ms){
+  unsigned long start = millis();
+  while(millis() - start < ms){
+    myNex.listen();
+  }
+}
+
+static void frameInPieces(){              // a frame split over many calls is finished by the last one
+  testDisplay display(Serial1);
+  nextion_ez myNex(Serial2);
+  setup(myNex);
+  display.send({0x65, 0x01});
+  listenFor(myNex, 2);
+  CHECK(!myNex.cmdAvail());
+  display.send({0x02, 0x01, 0xFF});
+  listenFor(myNex, 2);
+  CHECK(!myNex.cmdAvail());
+  display.send({0xFF, 0xFF});
+  listenFor(myNex, 2);
+  CHECK(myNex.cmdAvail());
+  CHECK_EQUAL(0x65, myNex.getCmd());
+  CHECK_EQUAL(1, myNex.readByte());
+  CHECK_EQUAL(2, myNex.readByte());
+  CHECK_EQUAL(1, myNex.readByte());
+  CHECK_EQUAL(0, myNex.getStats().skippedBytes);
+}
+
+static void brokenFrameIsDropped(){
+  testDisplay display(Serial1);
+  nextion_ez myNex(Serial2);
+  setup(myNex);
+  display.send({0x66});                   // the page number never comes
+  listenFor(myNex, 150);
+  CHECK_EQUAL(1, myNex.getStats().droppedFrames);
+  display.send({'#', 0x02, 'P', 0x02});
+  listenFor(myNex, 2);
+  CHECK_EQUAL(2, myNex.getCurrentPage());
+}
+
+static void strayZeroIsSkipped(){         // a 0x00 of line noise does not hide the commands after it
+  testDisplay display(Serial1);
+  nextion_ez myNex(Serial2);
+  setup(myNex);
+  display.send({0x00, '#', 0x02, 'P', 0x03});
+  display.send({'#', 0x02, 'T', 0x01});
+  listenFor(myNex, 5);
+  CHECK_EQUAL(3, myNex.getCurrentPage());
+  CHECK(myNex.cmdAvail());
+  CHECK_EQUAL('T', myNex.getCmd());
+}
+
+static void startUpFrame(){               // 0x00 0x00 0x00 0xFF 0xFF 0xFF is one frame, not a broken one
+  testDisplay display(Serial1);
+  nextion_ez myNex(Serial2);
+  setup(myNex);
+  display.send({0x00, 0x00, 0x00, 0xFF, 0xFF, 0xFF, '#', 0x02, 'P', 0x02});
+  listenFor(myNex, 5);
+  CHECK_EQUAL(2, myNex.getCurrentPage());
+  CHECK_EQUAL(0, myNex.getStats().droppedFrames);
+  CHECK_EQUAL(1, myNex.getStats().errorFrames);
+}
+
+static void readInCallback(uint8_t status, uint32_t){
+  if(status == NEX_OK){
+    nestedValue = nex->readNum("n1.val");  // listen() inside listen()
+  }
+}
+
+static void nestedListen(){               // the inner listen() takes bytes the outer one had counted
+  testDisplay display(Serial1);
+  display.numbers["n0.val"] = 5;
+  display.numbers["n1.val"] = 6;
+  nextion_ez myNex(Serial2);
+  setup(myNex);
+  nestedValue = 0;
+  myNex.requestNum("n0.val", readInCallback);
+  delay(5);                               // the reply is here, a touch event comes right behind it
+  display.send({0x65, 0x00, 0x03, 0x01, 0xFF, 0xFF, 0xFF});
+  delay(5);
+  listenFor(myNex, 20);
+  CHECK_EQUAL(6, nestedValue);
+  CHECK(myNex.cmdAvail());
+  CHECK_EQUAL(0x65, myNex.getCmd());
+  CHECK_EQUAL(0, myNex.getStats().skippedBytes);
+  CHECK_EQUAL(0, myNex.getStats().droppedFrames);
+}
+
+int main(){
+  RUN(frameInPieces);
+  RUN(brokenFrameIsDropped);
+  RUN(nestedListen);
+  RUN(strayZeroIsSkipped);
+  RUN(startUpFrame);
+  return CHECK_RESULT();
+}
@@ -0,0 +1,75 @@
+/*
+ * test_numbers.cpp - writeInt() and writeFixed(): the numbers as they go on the wire
+ * All rights reserved under the library's licence
+ */
+
+#include <cmath>
+#include <string>
+#include "check.h"
+#include "display.h"
+#include "nextion_ez.h"
+
+NEX_COMPONENT(temp, "x0.val");
+
+static void setup(nextion_ez& myNex){
+  Serial1.connect(Serial2);
+  Serial1.begin(115200);
+  myNex.begin(115200);
+}
+
+static std::string last(testDisplay& display){
+  delay(5);
+  return display.commands.empty() ? "" : display.commands.back();
+}
+
+static void fixedIsRounded(){             // half away from zero, like round()
+  testDisplay display(Serial1);
+  nextion_ez myNex(Serial2);
+  setup(myNex);
+  myNex.writeFixed("x0.val", 23.47f, 1);
+  CHECK(last(display) == "x0.val=235");
+  myNex.writeFixed("x0.val", -23.47f, 1);
+  CHECK(last(display) == "x0.val=-235");
+  myNex.writeFixed("x0.val", 1.25f, 1);
+  CHECK(last(display) == "x0.val=13");
+  myNex.writeFixed("x0.val", -1.25f, 1);
+  CHECK(last(display) == "x0.val=-13");
+  myNex.writeFixed("x0.val", 99.6f, 0);
+  CHECK(last(display) == "x0.val=100");
+  myNex.writeFixed("x0.val", -0.04f, 1);
+  CHECK(last(display) == "x0.val=0");
+}
+
+static void everyNameKind(){
+  testDisplay display(Serial1);
+  nextion_ez myNex(Serial2);
+  setup(myNex);
+  myNex.writeFixed(temp, 1.5f, 2);
+  CHECK(last(display) == "x0.val=150");
+  myNex.writeFixed(F("x1.val"), 0.125f, 3);
+  CHECK(last(display) == "x1.val=125");
+  myNex.writeFixed(String("x2.val"), -7.0f, 2);
+  CHECK(last(display) == "x2.val=-700");
+  CHECK_EQUAL(-700, (int32_t)display.numbers["x2.val"]);
+}
+
+static void outOfRange(){                 // the limits of an int32, and NaN as 0
+  testDisplay display(Serial1);
+  nextion_ez myNex(Serial2);
+  setup(myNex);
+  myNex.writeFixed("x0.val", 3e9f, 0);
+  CHECK(last(display) == "x0.val=2147483647");
+  myNex.writeFixed("x0.val", -30.0f, 9);
+  CHECK(last(display) == "x0.val=-2147483648");
+  myNex.writeFixed("x0.val", NAN, 1);
+  CHECK(last(display) == "x0.val=0");
+  myNex.writeInt("n0.val", -2147483647L - 1);
+  CHECK(last(display) == "n0.val=-2147483648");
+}
+
+int main(){
+  RUN(fixedIsRounded);
+  RUN(everyNameKind);
+  RUN(outOfRange);
+  return CHECK_RESULT();
+}
@@ -0,0 +1,110 @@
+/*
+ * test_pages.cpp - onPage(): the writes of a page that is not shown, built with NEXTION_EZ_PAGED 8
+ * and NEXTION_EZ_PAGED_TEXT 8
+ * All rights reserved under the library's licence
+ */
+
+#include <string>
+#include "check.h"
+#include "display.h"
+#include "nextion_ez.h"
+
+NEX_COMPONENT(speed, "n0.val");
+NEX_COMPONENT(label, "t0.txt");
+NEX_COMPONENT(other, "n1.val");
+
+static void setup(nextion_ez& myNex){
+  Serial1.connect(Serial2);
+  Serial1.begin(115200);
+  myNex.begin(115200);
+}
+
+static void listenFor(nextion_ez& myNex, unsigned long ms){
+  unsigned long start = millis();
+  while(millis() - start < ms){
+    myNex.listen();
+  }
+}
+
+static void loadPage(testDisplay& display, nextion_ez& myNex, uint8_t page){
+  display.send({'#', 0x02, 'P', page});   // printh 23 02 50 xx of the Preinitialize Event
+  listenFor(myNex, 5);
+}
+
+static void newestValueWaitsForItsPage(){
+  testDisplay display(Serial1);
+  nextion_ez myNex(Serial2);
+  setup(myNex);
+  CHECK(myNex.onPage(speed, 2));
+  CHECK(myNex.onPage(label, 2));
+  myNex.writeNum(speed, 5);
+  myNex.writeNum(speed, 6);
+  myNex.writeStr(label, "hi");
+  myNex.writeNum(other, 1);               // no page given, sent as always
+  listenFor(myNex, 5);
+  CHECK_EQUAL(1, display.commands.size());
+  loadPage(display, myNex, 2);
+  CHECK_EQUAL(3, display.commands.size());
+  CHECK(display.commands[1] == "n0.val=6");
+  CHECK(display.commands[2] == "t0.txt=\"hi\"");
+  myNex.writeNum(speed, 7);               // its page is shown now
+  loadPage(display, myNex, 1);
+  loadPage(display, myNex, 2);            // nothing was kept, nothing is sent again
+  CHECK_EQUAL(4, display.commands.size());
+  CHECK(display.commands[3] == "n0.val=7");
+}
+
+static void sendmeReplyLoadsThePage(){    // writeInt() keeps its sign
+  testDisplay display(Serial1);
+  nextion_ez myNex(Serial2);
+  setup(myNex);
+  myNex.onPage(speed, 3);
+  myNex.writeInt(speed, -5);
+  display.page = 3;
+  myNex.sendCmd("sendme");
+  listenFor(myNex, 5);
+  CHECK_EQUAL(3, myNex.getCurrentPage());
+  CHECK_EQUAL(2, display.commands.size());
+  CHECK(display.commands[1] == "n0.val=-5");
+}
+
+static void longTextIsSent(){             // longer than NEXTION_EZ_PAGED_TEXT, it cannot be kept
+  testDisplay display(Serial1);
+  nextion_ez myNex(Serial2);
+  setup(myNex);
+  myNex.onPage(label, 2);
+  myNex.writeStr(label, "12345678");
+  myNex.writeStr(label, "123456789");
+  loadPage(display, myNex, 2);
+  CHECK_EQUAL(1, display.commands.size());
+  CHECK(display.commands[0] == "t0.txt=\"123456789\"");  // the older kept text is not sent after it
+}
+
+static void fullTableAndClearPages(){
+  testDisplay display(Serial1);
+  nextion_ez myNex(Serial2);
+  setup(myNex);
+  std::string names[NEXTION_EZ_PAGED];   // only the key counts for onPage()
+  nextionComponent comps[NEXTION_EZ_PAGED];
+  for(int i = 0; i < NEXTION_EZ_PAGED; i++){
+    names[i] = "n" + std::to_string(i + 10) + ".val";
+    comps[i] = {"", "", 0, nexHash(names[i].c_str())};
+    CHECK(myNex.onPage(comps[i], 1));
+  }
+  CHECK(myNex.onPage(comps[0], 2));       // the same component again takes no entry
+  CHECK(!myNex.onPage(speed, 1));
+  myNex.clearPages();
+  CHECK(myNex.onPage(speed, 1));
+  myNex.clearPages();
+  myNex.writeNum(speed, 1);               // its page is forgotten, so it is sent
+  listenFor(myNex, 5);
+  CHECK_EQUAL(1, display.commands.size());
+}
+
+int main(){
+  RUN(newestValueWaitsForItsPage);
+  RUN(sendmeReplyLoadsThePage);
+  RUN(longTextIsSent);
+  RUN(fullTableAndClearPages);
+  return CHECK_RESULT();
+}
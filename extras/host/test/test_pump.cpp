@@ -0,0 +1,85 @@
+/*
+ * test_pump.cpp - the receive ring of pump(), built with NEXTION_EZ_RX_SIZE 256
+ * All rights reserved under the library's licence
+ */
+
+#include "check.h"
+#include "display.h"
+#include "nextion_ez.h"
+
+static nextion_ez* nex;
+
+class interruptingSerial : public Stream {  // an "interrupt" calls pump() in the middle of every read
+  public:
+    interruptingSerial(HardwareSerial& serial) : _serial(serial), _inside(false) {}
+    int available() { return _serial.available(); }
+    int peek() { return _serial.peek(); }
+    size_t write(uint8_t c) { return _serial.write(c); }
+    size_t write(const uint8_t* buffer, size_t size) { return _serial.write(buffer, size); }
+    int read(){
+      if(!_inside && nex != NULL){
+        _inside = true;
+        nex->pump();
+        _inside = false;
+      }
+      return _serial.read();
+    }
+  private:
+    HardwareSerial& _serial;
+    bool _inside;
+};
+
+static void busyLoopKeepsEvents(){        // 40 events arrive while the loop only calls pump()
+  Serial1.connect(Serial2);
+  Serial1.begin(115200);
+  testDisplay display(Serial1);
+  nextion_ez myNex(Serial2);
+  myNex.begin(115200);
+  for(uint8_t i = 0; i < 40; i++){       // 160 bytes, the Serial keeps 64
+    display.send({'#', 0x02, 'T', i});
+    delay(1);
+    myNex.pump();
+  }
+  CHECK_EQUAL(0, Serial2.lostBytes());
+  CHECK(myNex.rxHighWater() > 64);
+  int got = 0;
+  for(int i = 0; i < 40; i++){
+    myNex.listen();
+    while(myNex.cmdAvail()){
+      CHECK_EQUAL(got, myNex.readByte());
+      got++;
+    }
+  }
+  CHECK_EQUAL(40, got);
+}
+
+static void interruptInsidePump(){        // the pump() of the interrupt must not write the ring too
+  Serial1.connect(Serial2);
+  Serial1.begin(115200);
+  testDisplay display(Serial1);
+  interruptingSerial link(Serial2);
+  nextion_ez myNex(link);
+  nex = &myNex;
+  myNex.begin();
+  for(uint8_t i = 0; i < 10; i++){
+    display.send({'#', 0x02, 'T', i});
+  }
+  delay(10);
+  int got = 0;
+  for(int i = 0; i < 20; i++){
+    myNex.listen();
+    while(myNex.cmdAvail()){
+      CHECK_EQUAL('T', myNex.getCmd());
+      CHECK_EQUAL(got, myNex.readByte());
+      got++;
+    }
+  }
+  CHECK_EQUAL(10, got);
+  nex = NULL;
+}
+
+int main(){
+  RUN(busyLoopKeepsEvents);
+  RUN(interruptInsidePump);
+  return CHECK_RESULT();
+}
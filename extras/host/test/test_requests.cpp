@@ -0,0 +1,217 @@
+/*
+ * test_requests.cpp - requestNum(), requestStr(), readNum() and the errors of Nextion
+ * All rights reserved under the library's licence
+ */
+
+#include "check.h"
+#include "display.h"
+#include "nextion_ez.h"
+
+static uint8_t gotStatus;
+static uint32_t gotValue;
+static int gotCalls;
+
+static void gotNumber(uint8_t status, uint32_t value){
+  gotStatus = status;
+  gotValue = value;
+  gotCalls++;
+}
+
+static void setup(nextion_ez& myNex){
+  Serial1.connect(Serial2);
+  Serial1.begin(115200);
+  myNex.begin(115200);
+  gotCalls = 0;
+}
+
+static void requestNumDoesNotWait(){
+  testDisplay display(Serial1);
+  display.numbers["n0.val"] = 1234;
+  nextion_ez myNex(Serial2);
+  setup(myNex);
+  unsigned long start = millis();
+  CHECK(myNex.requestNum("n0.val", gotNumber));
+  CHECK(millis() - start < 2);
+  CHECK_EQUAL(1, myNex.pendingRequests());
+  while(gotCalls == 0 && millis() - start < 100){
+    myNex.listen();
+  }
+  CHECK_EQUAL(1, gotCalls);
+  CHECK_EQUAL(NEX_OK, gotStatus);
+  CHECK_EQUAL(1234, gotValue);
+}
+
+static void requestTimesOut(){
+  testDisplay display(Serial1);
+  display.answer = false;
+  nextion_ez myNex(Serial2);
+  setup(myNex);
+  myNex.setRequestTimeout(50);
+  myNex.requestNum("n0.val", gotNumber);
+  unsigned long start = millis();
+  while(gotCalls == 0 && millis() - start < 200){
+    myNex.listen();
+  }
+  CHECK_EQUAL(NEX_TIMEOUT, gotStatus);
+  CHECK(millis() - start >= 50);
+}
+
+static void wrongNameFailsAtOnce(){       // nothing else was sent, so the 0x1A is the answer of the get
+  testDisplay display(Serial1);
+  nextion_ez myNex(Serial2);
+  setup(myNex);
+  unsigned long start = millis();
+  CHECK_EQUAL(777777, myNex.readNum("x9.val"));
+  CHECK(millis() - start < 50);
+  CHECK_EQUAL(0x1A, myNex.getLastError());
+}
+
+static void errorOfAWriteBeforeTheGet(){  // the 0x1A is for the write, the get still gets its value
+  testDisplay display(Serial1);
+  display.numbers["n0.val"] = 42;
+  nextion_ez myNex(Serial2);
+  setup(myNex);
+  myNex.writeNum("bad.val", 1);
+  CHECK_EQUAL(42, myNex.readNum("n0.val"));
+  CHECK_EQUAL(0x1A, myNex.getLastError());
+}
+
+static void errorAfterAnsweredWrites(){   // once a get is answered, the writes before it are done
+  testDisplay display(Serial1);
+  display.numbers["n0.val"] = 42;
+  nextion_ez myNex(Serial2);
+  setup(myNex);
+  myNex.writeNum("n1.val", 1);
+  CHECK_EQUAL(42, myNex.readNum("n0.val"));
+  CHECK(myNex.requestNum("x9.val", gotNumber));
+  unsigned long start = millis();
+  while(gotCalls == 0 && millis() - start < 100){
+    myNex.listen();
+  }
+  CHECK_EQUAL(NEX_ERROR, gotStatus);
+}
+
+static void flowControlMatchesErrors(){   // with bkcmd=3 each answer belongs to one command
+  testDisplay display(Serial1);
+  display.numbers["n0.val"] = 42;
+  nextion_ez myNex(Serial2);
+  setup(myNex);
+  myNex.useFlowControl(true);
+  myNex.writeNum("n1.val", 1);
+  myNex.requestNum("x9.val", gotNumber);
+  unsigned long start = millis();
+  while(gotCalls == 0 && millis() - start < 100){
+    myNex.listen();
+  }
+  CHECK_EQUAL(NEX_ERROR, gotStatus);
+  myNex.writeNum("bad.val", 1);
+  CHECK_EQUAL(42, myNex.readNum("n0.val"));
+}
+
+static void readNumsMarksFailures(){      // without a status array, the count comes from the replies
+  testDisplay display(Serial1);
+  display.numbers["n0.val"] = 777777;     // a real value that looks like a failure
+  display.numbers["n2.val"] = 3;
+  nextion_ez myNex(Serial2);
+  setup(myNex);
+  const char* names[] = {"n0.val", "x1.val", "n2.val"};
+  uint32_t values[3] = {1, 1, 1};
+  CHECK_EQUAL(2, myNex.readNums(names, values, NULL, 3, 200));
+  CHECK_EQUAL(777777, values[0]);
+  CHECK_EQUAL(777777, values[1]);
+  CHECK_EQUAL(3, values[2]);
+}
+
+static void readNumsTimesOut(){           // the unsent and unanswered values are 777777 too
+  testDisplay display(Serial1);
+  display.answer = false;
+  nextion_ez myNex(Serial2);
+  setup(myNex);
+  const char* names[NEXTION_EZ_REQUESTS + 2];
+  uint32_t values[NEXTION_EZ_REQUESTS + 2];
+  uint8_t status[NEXTION_EZ_REQUESTS + 2];
+  for(int i = 0; i < NEXTION_EZ_REQUESTS + 2; i++){
+    names[i] = "n0.val";
+    values[i] = 1;
+  }
+  CHECK_EQUAL(0, myNex.readNums(names, values, status, NEXTION_EZ_REQUESTS + 2, 50));
+  for(int i = 0; i < NEXTION_EZ_REQUESTS + 2; i++){
+    CHECK_EQUAL(777777, values[i]);
+    CHECK_EQUAL(NEX_TIMEOUT, status[i]);
+  }
+}
+
+static void lateReplyIsDropped(){         // the reply of a get that timed out is not the value of the next one
+  testDisplay display(Serial1);
+  display.numbers["n1.val"] = 2222;
+  nextion_ez myNex(Serial2);
+  setup(myNex);
+  myNex.setRequestTimeout(50);
+  display.answer = false;
+  CHECK_EQUAL(777777, myNex.readNum("n0.val"));
+  display.answer = true;
+  display.send({0x71, 0x57, 0x04, 0x00, 0x00, 0xFF, 0xFF, 0xFF});  // 1111, the answer of n0.val at last
+  CHECK_EQUAL(2222, myNex.readNum("n1.val"));
+  CHECK_EQUAL(2222, myNex.readNum("n1.val"));
+}
+
+static void lostReplyCostsOneRead(){      // a reply that never comes makes only the next read fail
+  testDisplay display(Serial1);
+  display.numbers["n1.val"] = 2222;
+  nextion_ez myNex(Serial2);
+  setup(myNex);
+  myNex.setRequestTimeout(50);
+  display.answer = false;
+  CHECK_EQUAL(777777, myNex.readNum("n0.val"));
+  display.answer = true;
+  CHECK_EQUAL(777777, myNex.readNum("n1.val"));  // its reply was taken for the late one
+  CHECK_EQUAL(2222, myNex.readNum("n1.val"));
+  CHECK_EQUAL(2222, myNex.readNum("n1.val"));
+}
+
+static bool gotCommand(const testDisplay& display, const std::string& command){
+  for(const std::string& c : display.commands){
+    if(c == command) return true;
+  }
+  return false;
+}
+
+static void batchGoesOnAfterRead(){       // a read sends what is held, but the batch lasts until flush()
+  testDisplay display(Serial1);
+  display.numbers["n1.val"] = 7;
+  display.texts["t0.txt"] = "abc";
+  nextion_ez myNex(Serial2);
+  setup(myNex);
+  const char* names[2] = {"n1.val", "n1.val"};
+  uint32_t values[2];
+  myNex.beginBatch();
+  myNex.writeNum("n0.val", 1);
+  CHECK_EQUAL(7, myNex.readNum("n1.val"));
+  CHECK(gotCommand(display, "n0.val=1"));
+  myNex.writeNum("n2.val", 2);
+  CHECK(myNex.readStr("t0.txt") == "abc");
+  myNex.writeNum("n3.val", 3);
+  CHECK_EQUAL(2, myNex.readNums(names, values, NULL, 2, 100));
+  myNex.writeNum("n4.val", 4);
+  delay(20);
+  CHECK(gotCommand(display, "n3.val=3"));
+  CHECK(!gotCommand(display, "n4.val=4"));  // still held
+  myNex.flush();
+  delay(20);
+  CHECK(gotCommand(display, "n4.val=4"));
+}
+
+int main(){
+  RUN(requestNumDoesNotWait);
+  RUN(requestTimesOut);
+  RUN(wrongNameFailsAtOnce);
+  RUN(errorOfAWriteBeforeTheGet);
+  RUN(errorAfterAnsweredWrites);
+  RUN(flowControlMatchesErrors);
+  RUN(readNumsMarksFailures);
+  RUN(readNumsTimesOut);
+  RUN(lateReplyIsDropped);
+  RUN(lostReplyCostsOneRead);
+  RUN(batchGoesOnAfterRead);
+  return CHECK_RESULT();
+}
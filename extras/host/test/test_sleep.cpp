@@ -0,0 +1,77 @@
+/*
+ * test_sleep.cpp - the writes kept while Nextion sleeps, built with NEXTION_EZ_PAGED_TEXT 8
+ * All rights reserved under the library's licence
+ */
+
+#include <algorithm>
+#include <cstring>
+#include "check.h"
+#include "display.h"
+#include "nextion_ez.h"
+
+NEX_COMPONENT(speed, "n0.val");
+
+static void setup(nextion_ez& myNex){
+  Serial1.connect(Serial2);
+  Serial1.begin(115200);
+  myNex.begin(115200);
+}
+
+static void listenFor(nextion_ez& myNex, unsigned long ms){
+  unsigned long start = millis();
+  while(millis() - start < ms){
+    myNex.listen();
+  }
+}
+
+static void plainNamesAreKept(){          // the name is copied, the text of the caller can change
+  testDisplay display(Serial1);
+  nextion_ez myNex(Serial2);
+  setup(myNex);
+  display.send({0x86, 0xFF, 0xFF, 0xFF});
+  listenFor(myNex, 5);
+  CHECK(myNex.isAsleep());
+  char name[8] = "n1.val";
+  myNex.writeNum(name, 1);
+  myNex.writeNum(name, 2);
+  strcpy(name, "xx.val");
+  myNex.writeInt(F("n2.val"), -3);
+  myNex.writeStr("t0.txt", "hi");
+  myNex.writeNum(speed, 4);
+  listenFor(myNex, 5);
+  CHECK_EQUAL(0, display.commands.size());
+  display.send({0x87, 0xFF, 0xFF, 0xFF});
+  listenFor(myNex, 10);
+  CHECK(!myNex.isAsleep());
+  CHECK_EQUAL(4, display.commands.size());
+  CHECK(std::find(display.commands.begin(), display.commands.end(), "n1.val=2") != display.commands.end());
+  CHECK(std::find(display.commands.begin(), display.commands.end(), "n2.val=-3") != display.commands.end());
+  CHECK(std::find(display.commands.begin(), display.commands.end(), "t0.txt=\"hi\"") != display.commands.end());
+  CHECK(std::find(display.commands.begin(), display.commands.end(), "n0.val=4") != display.commands.end());
+  CHECK_EQUAL(0, myNex.lostWrites());
+}
+
+static void dropsAreCounted(){            // a full table, a long name and a long text are lost, and counted
+  testDisplay display(Serial1);
+  nextion_ez myNex(Serial2);
+  setup(myNex);
+  display.send({0x86, 0xFF, 0xFF, 0xFF});
+  listenFor(myNex, 5);
+  myNex.writeNum("page1.longname0.val", 1);
+  myNex.writeStr("t0.txt", "much too long");
+  char name[8] = "n0.val";
+  for(int i = 0; i < NEXTION_EZ_PAGED + 1; i++){
+    name[1] = '0' + i;
+    myNex.writeNum(name, i);
+  }
+  CHECK_EQUAL(3, myNex.lostWrites());    // the name, the text and 1 of the 9 numbers, the text took no entry
+  display.send({0x87, 0xFF, 0xFF, 0xFF});
+  listenFor(myNex, 10);
+  CHECK_EQUAL(NEXTION_EZ_PAGED, display.commands.size());
+}
+
+int main(){
+  RUN(plainNamesAreKept);
+  RUN(dropsAreCounted);
+  return CHECK_RESULT();
+}
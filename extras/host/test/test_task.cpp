@@ -0,0 +1,130 @@
+/*
+ * test_task.cpp - beginTask() on the PC: the library thread, four app threads and the display thread
+ * together, on the real clock. Built with NEXTION_EZ_TASK 1 and NEXTION_EZ_STATS 1 (and NEXTION_EZ_NATIVE_EVENTS 1 for the touch events)
+ * All rights reserved under the library's licence
+ */
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "check.h"
+#include "display.h"
+#include "nextion_ez.h"
+
+#define APP_THREADS 4
+#define ROUNDS      100
+#define TOUCHES     200
+
+static std::atomic<int> touches(0);
+static std::atomic<int> answers(0);
+static std::atomic<int> wrongAnswers(0);
+
+static void touched(uint8_t, const uint8_t* data, uint8_t length){  // runs in the library thread
+  if(length == 3 && data[0] == 0x00 && data[1] == 0x05) touches++;
+}
+
+static void gotNumber(uint8_t status, uint32_t value){
+  if(status == NEX_OK && value % 100 == 0 && value <= 100 * APP_THREADS){
+    answers++;
+  }else{
+    wrongAnswers++;
+  }
+}
+
+static void appThread(nextion_ez* myNex, int id, int* wrong){
+  char writeName[8] = "n0.val";
+  char readName[8] = "m0.val";
+  writeName[1] = '0' + id;
+  readName[1] = '0' + id;
+  for(uint32_t i = 0; i < ROUNDS; i++){
+    myNex->writeNum(writeName, i);
+    if(myNex->readNum(readName) != (uint32_t)(100 * (id + 1))) (*wrong)++;  // never the reply of another thread
+    if(!myNex->requestNum(readName, gotNumber)) (*wrong)++;
+  }
+}
+
+static void manyThreads(){
+  hostRealTime(true);
+  Serial1.setBuffers(1024, 64);           // the input buffer of a Nextion
+  Serial1.connect(Serial2);
+  Serial1.begin(921600);
+  testDisplay display(Serial1);
+  for(int id = 0; id < APP_THREADS; id++){
+    char name[8] = "m0.val";
+    name[1] = '0' + id;
+    display.numbers[name] = 100 * (id + 1);
+  }
+  std::atomic<bool> running(true);
+  std::atomic<bool> ready(false);
+  std::thread nextion([&](){              // the display, with a touch event every 2ms once the handler is set
+    unsigned long last = millis();
+    int sent = 0;
+    while(running){
+      display.run();
+      if(ready && sent < TOUCHES && millis() - last >= 2){
+        display.send({0x65, 0x00, 0x05, 0x01, 0xFF, 0xFF, 0xFF});
+        last = millis();
+        sent++;
+      }
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+  });
+
+  Serial2.setBuffers(1024, 64);           // 92 bytes come in each 1ms sleep of the library thread, an ESP32 has 256
+  nextion_ez myNex(Serial2);
+  CHECK(myNex.beginTask(921600));
+  myNex.onCommand(0x65, touched);         // after beginTask(), begin() clears the handlers
+  ready = true;
+  int wrong[APP_THREADS] = {0};
+  std::vector<std::thread> apps;
+  for(int id = 0; id < APP_THREADS; id++){
+    apps.push_back(std::thread(appThread, &myNex, id, &wrong[id]));
+  }
+  for(size_t i = 0; i < apps.size(); i++){
+    apps[i].join();
+  }
+  unsigned long start = millis();
+  while((touches < TOUCHES || myNex.pendingRequests() > 0) && millis() - start < 2000){
+    delay(1);
+  }
+  myNex.endTask();
+  running = false;
+  nextion.join();
+
+  for(int id = 0; id < APP_THREADS; id++){
+    CHECK_EQUAL(0, wrong[id]);
+  }
+  CHECK_EQUAL(APP_THREADS * ROUNDS, answers.load());
+  CHECK_EQUAL(0, wrongAnswers.load());
+  CHECK_EQUAL(TOUCHES, touches.load());
+  CHECK_EQUAL(0, Serial1.lostBytes());
+  CHECK_EQUAL(0, Serial2.lostBytes());
+  CHECK_EQUAL(0, myNex.getStats().skippedBytes);
+  CHECK_EQUAL(0, myNex.getStats().droppedFrames);
+  int writes = 0;
+  for(size_t i = 0; i < display.commands.size(); i++){
+    if(display.commands[i][0] == 'n') writes++;
+  }
+  CHECK_EQUAL(APP_THREADS * ROUNDS, writes);
+}
+
+static void endTaskStopsTheThread(){      // listen() is called by nobody after endTask()
+  hostRealTime(true);
+  Serial1.connect(Serial2);
+  Serial1.begin(115200);
+  testDisplay display(Serial1);
+  nextion_ez myNex(Serial2);
+  myNex.beginTask(115200);
+  myNex.endTask();
+  display.send({'#', 0x02, 'P', 0x04});
+  delay(20);
+  CHECK_EQUAL(0, myNex.getCurrentPage());
+  myNex.listen();
+  CHECK_EQUAL(4, myNex.getCurrentPage());
+}
+
+int main(){
+  RUN(manyThreads);
+  RUN(endTaskStopsTheThread);
+  return CHECK_RESULT();
+}
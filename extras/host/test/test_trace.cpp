@@ -0,0 +1,105 @@
+/*
+ * test_trace.cpp - traceTo() records the link, nextionReplay plays it again
+ * All rights reserved under the library's licence
+ */
+
+#include <vector>
+#include "check.h"
+#include "display.h"
+#include "nextion_ez.h"
+
+class traceFile : public Stream {         // keeps what is written, like a file on an SD card
+  public:
+    std::vector<uint8_t> bytes;
+    size_t write(uint8_t c){
+      bytes.push_back(c);
+      return 1;
+    }
+    using Print::write;
+    int available() { return 0; }
+    int read() { return -1; }
+    int peek() { return -1; }
+};
+
+static uint32_t session(nextion_ez& myNex, bool replayed){  // the code of the sketch, recorded and then replayed
+  myNex.begin(115200);
+  myNex.writeNum("n0.val", 7);
+  myNex.writeStr("t0.txt", "abc");
+  uint32_t value = myNex.readNum("n1.val");
+  myNex.sendCmd("sendme");                // the page comes back as a frame of its own
+  unsigned long start = millis();
+  while(!replayed && millis() - start < 20){  // a replay is listened to until done()
+    myNex.listen();
+  }
+  return value;
+}
+
+static void replayMatches(){
+  Serial1.connect(Serial2);
+  Serial1.begin(115200);
+  testDisplay display(Serial1);
+  display.numbers["n1.val"] = 42;
+  nextion_ez myNex(Serial2);
+  traceFile file;
+  myNex.traceTo(file);
+  display.page = 2;
+  CHECK_EQUAL(42, session(myNex, false));
+  myNex.traceStop();
+  CHECK(file.bytes.size() > 40);
+  CHECK_EQUAL(2, myNex.getCurrentPage());
+
+  nextionReplay replay(file.bytes.data(), file.bytes.size(), 0);
+  nextion_ez played(replay);
+  CHECK_EQUAL(42, session(played, true));
+  unsigned long start = millis();
+  while(!replay.done() && millis() - start < 100){
+    played.listen();
+  }
+  CHECK(replay.done());
+  CHECK_EQUAL(0, replay.txMismatches());
+  CHECK_EQUAL(2, played.getCurrentPage());
+}
+
+static void otherCodeIsSeen(){            // a change of the sketch shows as bytes that differ
+  Serial1.connect(Serial2);
+  Serial1.begin(115200);
+  testDisplay display(Serial1);
+  nextion_ez myNex(Serial2);
+  traceFile file;
+  myNex.traceTo(file);
+  myNex.begin(115200);
+  myNex.writeNum("n0.val", 7);
+  myNex.traceStop();
+
+  nextionReplay replay(file.bytes.data(), file.bytes.size(), 0);
+  nextion_ez played(replay);
+  played.begin(115200);
+  played.writeNum("n0.val", 8);
+  CHECK_EQUAL(1, replay.txMismatches());
+}
+
+static void arrayKeepsTheNewest(){
+  Serial1.connect(Serial2);
+  Serial1.begin(115200);
+  testDisplay display(Serial1);
+  nextion_ez myNex(Serial2);
+  uint8_t trace[64];
+  myNex.traceTo(trace, sizeof(trace));
+  myNex.begin(115200);
+  for(uint32_t i = 100; i < 120; i++){
+    myNex.writeNum("n0.val", i);          // 13 bytes and a record of 3 each
+  }
+  traceFile file;
+  myNex.traceDump(file);
+  CHECK(file.bytes.size() <= sizeof(trace));
+  CHECK_EQUAL(0x80 | 13, file.bytes[0]);  // whole records only
+  std::string last(file.bytes.end() - 13, file.bytes.end());
+  CHECK(last == "n0.val=119\xFF\xFF\xFF");
+}
+
+int main(){
+  RUN(replayMatches);
+  RUN(otherCodeIsSeen);
+  RUN(arrayKeepsTheNewest);
+  return CHECK_RESULT();
+}
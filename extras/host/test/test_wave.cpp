@@ -0,0 +1,129 @@
+/*
+ * test_wave.cpp - streamWave() and sampleWave(): the addt exchange, and the addt that fails
+ * All rights reserved under the library's licence
+ */
+
+#include <string>
+#include "check.h"
+#include "display.h"
+#include "nextion_ez.h"
+
+static void setup(nextion_ez& myNex){
+  Serial1.connect(Serial2);
+  Serial1.begin(115200);
+  myNex.begin(115200);
+}
+
+static void listenFor(nextion_ez& myNex, unsigned long ms){
+  unsigned long start = millis();
+  while(millis() - start < ms){
+    myNex.listen();
+  }
+}
+
+static int seen(const testDisplay& display, const std::string& start){
+  int count = 0;
+  for(const std::string& c : display.commands){
+    if(c.compare(0, start.size(), start) == 0) count++;
+  }
+  return count;
+}
+
+static void blockGoesWithAddt(){
+  testDisplay display(Serial1);
+  display.waveIds.push_back(1);
+  nextion_ez myNex(Serial2);
+  setup(myNex);
+  for(uint8_t i = 0; i < NEXTION_EZ_WAVE_BLOCK; i++){
+    CHECK(myNex.streamWave(1, 0, 0xF0 + i));  // 0xFF inside the data too
+  }
+  listenFor(myNex, 20);
+  CHECK_EQUAL(1, seen(display, "addt 1,0,"));
+  CHECK_EQUAL(NEXTION_EZ_WAVE_BLOCK, display.waveData.size());
+  CHECK_EQUAL(0xFF, display.waveData[15]);
+}
+
+static void sampledColumnsGoWithAddt(){
+  testDisplay display(Serial1);
+  display.waveIds.push_back(1);
+  nextion_ez myNex(Serial2);
+  setup(myNex);
+  CHECK(myNex.setWaveDecimation(1, 0, 4, NEX_WAVE_MEAN, 1023));
+  for(int i = 0; i < 4 * NEXTION_EZ_WAVE_BLOCK; i++){
+    CHECK(myNex.sampleWave(1, 0, 1023));
+  }
+  listenFor(myNex, 20);
+  CHECK_EQUAL(1, seen(display, "addt 1,0,"));
+  CHECK_EQUAL(NEXTION_EZ_WAVE_BLOCK, display.waveData.size());
+  CHECK_EQUAL(255, display.waveData[0]);
+}
+
+static void rejectedAddtWaits(){          // 0x02 ends the block at once, the next try comes later and later
+  testDisplay display(Serial1);
+  nextion_ez myNex(Serial2);
+  setup(myNex);
+  CHECK(myNex.setWaveDecimation(5, 0, 1, NEX_WAVE_MEAN, 255));
+  for(uint8_t i = 0; i < NEXTION_EZ_WAVE_BLOCK; i++){
+    myNex.streamWave(4, 0, i);
+    myNex.sampleWave(5, 0, i);
+  }
+  unsigned long start = millis();
+  for(uint32_t i = 0; i < 20; i++){
+    myNex.writeNum("n0.val", i);          // more than the transmit buffer holds
+  }
+  CHECK(millis() - start < 50);           // no wait for a timeout
+  listenFor(myNex, 2000);
+  CHECK_EQUAL(19, display.numbers["n0.val"]);
+  CHECK_EQUAL(0x02, myNex.getLastError());
+  CHECK_EQUAL(3, seen(display, "addt 4,0,"));  // at 0, 0.5 and 1.5 s
+  CHECK_EQUAL(3, seen(display, "addt 5,0,"));
+  CHECK_EQUAL(0, display.waveData.size());
+}
+
+static void unansweredAddtDoesNotLock(){  // the writes behind a block wait only for the timeout of addt
+  testDisplay display(Serial1);
+  display.waveIds.push_back(1);
+  display.answer = false;
+  nextion_ez myNex(Serial2);
+  setup(myNex);
+  for(uint8_t i = 0; i < NEXTION_EZ_WAVE_BLOCK; i++){
+    myNex.streamWave(1, 0, i);
+  }
+  myNex.listen();                         // addt is sent
+  unsigned long start = millis();
+  for(uint32_t i = 0; i < 20; i++){
+    myNex.writeNum("n0.val", i);          // the full transmit buffer waits for the block
+  }
+  CHECK(millis() - start < 1000);
+  listenFor(myNex, 20);
+  CHECK_EQUAL(1, seen(display, "addt 1,0,"));
+  CHECK_EQUAL(1, seen(display, "n0.val=19"));
+  display.answer = true;
+  listenFor(myNex, 1000);                 // the next try, after 0.5 s
+  CHECK_EQUAL(2, seen(display, "addt 1,0,"));
+  CHECK_EQUAL(NEXTION_EZ_WAVE_BLOCK, display.waveData.size());
+}
+
+static void errorOfAnEarlierWrite(){      // an 0x1A is not the answer of addt, the block goes on
+  testDisplay display(Serial1);
+  display.waveIds.push_back(1);
+  nextion_ez myNex(Serial2);
+  setup(myNex);
+  myNex.writeNum("bad0.val", 1);
+  for(uint8_t i = 0; i < NEXTION_EZ_WAVE_BLOCK; i++){
+    myNex.streamWave(1, 0, i);
+  }
+  listenFor(myNex, 20);
+  CHECK_EQUAL(0x1A, myNex.getLastError());
+  CHECK_EQUAL(1, seen(display, "addt 1,0,"));
+  CHECK_EQUAL(NEXTION_EZ_WAVE_BLOCK, display.waveData.size());
+}
+
+int main(){
+  RUN(blockGoesWithAddt);
+  RUN(sampledColumnsGoWithAddt);
+  RUN(rejectedAddtWaits);
+  RUN(unansweredAddtDoesNotLock);
+  RUN(errorOfAnEarlierWrite);
+  return CHECK_RESULT();
+}
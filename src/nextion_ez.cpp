@@ -10,6 +10,46 @@
 #include "nextion_ez.h"
 #endif
 
+#define NEX_LEN_VARIABLE 0xFF   // frameLength() results, used by the frame parser of listen()
+#define NEX_LEN_UNKNOWN  0xFE
+
+#define NEX_BULK_HEADER 6        // <ack> <len> <key 4 bytes> before each command of the bulk queue
+#define NEX_BULK_DEAD   0xFF     // <ack> of a command replaced by a newer value
+
+#if NEXTION_EZ_TASK
+ #if defined(ESP32)
+ #define NEX_LOCK(mutex)   xSemaphoreTakeRecursive(mutex, portMAX_DELAY)
+ #define NEX_UNLOCK(mutex) xSemaphoreGiveRecursive(mutex)
+ #else
+ #define NEX_LOCK(mutex)   (mutex)->lock()
+ #define NEX_UNLOCK(mutex) (mutex)->unlock()
+ #endif
+class nexGuard {                 // holds the mutex of beginTask() until the end of the function
+  public:
+    nexGuard(nexMutex mutex) : _mutex(mutex) {
+      if(_mutex != NULL) NEX_LOCK(_mutex);
+    }
+    ~nexGuard() {
+      if(_mutex != NULL) NEX_UNLOCK(_mutex);
+    }
+  private:
+    nexMutex _mutex;
+};
+ #define NEX_GUARD() nexGuard guard(_mutex)
+#else
+ #define NEX_GUARD()
+#endif
+
+#if NEXTION_EZ_STATS
+ #define NEX_STAT(count) count     // the counters of getStats()
+#else
+ #define NEX_STAT(count)           // compiled out
+#endif
+
+#define NEX_TRACE_SENT   0x80    // first byte of a trace record: <sent|length> <ms low> <ms high>, then the bytes
+#define NEX_TRACE_LENGTH 0x7F
+#define NEX_TRACE_HEADER 3
+
 //#ifndef trigger_h
 //#include "trigger.h"
 //#endif
@@ -20,16 +60,132 @@
 
 nextion_ez::nextion_ez(HardwareSerial& serial){  // Constructor's parameter is the Serial we want to use
   _serial = &serial;
+  _hwSerial = &serial;
+  _currentPageId = 0;      // Nextion starts on page 0, assumed until a 'P' command or the reply of sendme
+  _lastCurrentPageId = 0;
+#if NEXTION_EZ_TASK
+  _mutex = NULL;
+  _task = NULL;
+ #if !defined(ESP32)
+  _taskRun = false;
+ #endif
+#endif
+#if NEXTION_EZ_TRACE
+  _traceOn = false;        // traceTo() can be called before begin(), to record it too
+  _traceOut = NULL;
+  _traceRing = NULL;
+  _traceUsed = 0;
+  _traceLen = 0;
+#endif
+}
+
+nextion_ez::nextion_ez(Stream& serial){  // SoftwareSerial, USB Serial or any other Stream, started by the sketch
+  _serial = &serial;
+  _hwSerial = NULL;
+  _currentPageId = 0;      // Nextion starts on page 0, assumed until a 'P' command or the reply of sendme
+  _lastCurrentPageId = 0;
+#if NEXTION_EZ_TASK
+  _mutex = NULL;
+  _task = NULL;
+ #if !defined(ESP32)
+  _taskRun = false;
+ #endif
+#endif
+#if NEXTION_EZ_TRACE
+  _traceOn = false;        // traceTo() can be called before begin(), to record it too
+  _traceOut = NULL;
+  _traceRing = NULL;
+  _traceUsed = 0;
+  _traceLen = 0;
+#endif
 }
+
+#if NEXTION_EZ_TASK && !defined(ESP32)
+nextion_ez::~nextion_ez(){
+  endTask();
+  delete _mutex;
+}
+#endif
 //------------------------------------------------------------------------------
 void nextion_ez::begin(unsigned long baud){
-  _serial->begin(baud);  // We pass the initialization data to the objects (baud rate) default: 9600
+  NEX_GUARD();
+  setBaud(baud);         // We pass the initialization data to the objects (baud rate) default: 9600
   
   delay(100);            // Wait for the Serial to initialize
 
   _cmdFifoHead = 0;     // setup FIFO 
   _cmdFifoTail = 0;
-  _cmdAvail = false;
+  _eventTail = 0;          // setup the command queue of cmdAvail()
+  _eventCount = 0;
+  _handlerCount = 0;
+
+  _reqHead = 0;         // setup the request queue for requestNum() and requestStr()
+  _reqTail = 0;
+  _reqCount = 0;
+  _reqTimeout = 400UL;
+  _syncDone = true;
+  _writeCount = 0;
+  _writesAnswered = 0;
+  _lateReplies = 0;
+  _lateDropped = false;
+
+  _cacheOn = false;     // the cache of sent values is off until useCache(true)
+  _cacheNext = 0;
+  _cacheHeld = false;
+  _txCached = false;
+  clearCache();
+
+  _waveState = NEX_WAVE_IDLE;  // setup streamWave()
+  _txWaiting = false;
+  _waveNext = 0;
+  _waveFlush = false;
+#if NEXTION_EZ_WAVE_CHANNELS > 0
+  for(uint8_t i = 0; i < NEXTION_EZ_WAVE_CHANNELS; i++){
+    _wave[i].used = false;
+  }
+#endif
+
+  _txLen = 0;           // setup the transmit buffer
+  _txHold = false;
+  _txCmdBytes = 0;
+
+  _flowOn = false;      // setup useFlowControl()
+  _flowHead = 0;
+  _flowTail = 0;
+  _flowCount = 0;
+  _flowBytes = 0;
+  _flowMaxCmds = NEXTION_EZ_WINDOW;
+  _flowMaxBytes = 512;
+  _flowWaiting = false;
+  _flowUnsent = 0;
+  _cmdId = 0;
+  _cmdCallback = NULL;
+
+  _rxState = NEX_RX_IDLE;  // setup the frame parser of listen()
+  _cmdCount = 0;
+  _cmdRead = 0;
+  _lastError = 0;
+  _gotPage = false;
+  
+  _pagedCount = 0;         // setup the table of onPage()
+  _asleep = false;
+  _lostWrites = 0;
+  _sleepCallback = NULL;
+  
+  _txKey = 0;              // setup the bulk queue of setPriority()
+  _txPriority = NEX_PRIO_HIGH;
+  _bulkTail = 0;
+  _bulkUsed = 0;
+  _txRoomMax = 0;
+
+#if NEXTION_EZ_STATS
+  resetStats();
+  _statsCallback = NULL;
+#endif
+
+  rxClear();               // setup the receive ring of pump()
+  _rxHighWater = 0;
+  _rxOverruns = 0;
 
   _tmr1 = millis();
   while(_serial->available() > 0){     // Read the Serial until it is empty. This is used to clear Serial buffer
@@ -40,33 +196,314 @@ void nextion_ez::begin(unsigned long baud){
   }
 }
 //------------------------------------------------------------------------------
-int nextion_ez::getCurrentPage(){   //returns the current page id
+/*
+ * -- beginAuto(unsigned long): like begin(), but finds the baud rate the Nextion uses and then
+ * moves both sides to the fastest rate allowed, with the "baud=" command.
+ * unsigned long = the highest baud rate to use (example: 115200, up to 921600 if the board can do it).
+ * The fastest rate of Nextion that is not above it is used, so 100000 gives 57600.
+ * The link is checked at the new rate with "sendme"; if Nextion does not answer, the old rate is used again.
+ * Returns the baud rate in use, or 0 if no Nextion answered at any rate.
+ * Only with a HardwareSerial, for any other Stream it is the same as begin() and returns 0.
+ * Syntax: | unsigned long baud = myObject.beginAuto(115200); |
+ */
+static const uint32_t NEX_BAUDS[] PROGMEM = {9600, 115200, 19200, 38400, 57600, 230400,
+                                             250000, 256000, 512000, 921600, 2400, 4800, 31250};
+#define NEX_BAUD_COUNT (sizeof(NEX_BAUDS) / sizeof(NEX_BAUDS[0]))
+
+unsigned long nextion_ez::beginAuto(unsigned long maxBaud){
+  NEX_GUARD();
+  begin(9600);                          // setup everything else as begin() does
+  if(_hwSerial == NULL){
+    return 0;                           // the baud rate of a Stream cannot be changed by the library
+  }
+  
+  unsigned long baud = 0;
+  for(uint8_t i = 0; i < NEX_BAUD_COUNT; i++){  // the usual rates first
+    unsigned long rate = pgm_read_dword(&NEX_BAUDS[i]);
+    setBaud(rate);
+    if(probe()){
+      baud = rate;
+      break;
+    }
+  }
+  
+  unsigned long fastest = 0;            // Nextion answers "baud=" with an error for any other rate
+  for(uint8_t i = 0; i < NEX_BAUD_COUNT; i++){
+    unsigned long rate = pgm_read_dword(&NEX_BAUDS[i]);
+    if(rate <= maxBaud && rate > fastest){
+      fastest = rate;
+    }
+  }
+  maxBaud = fastest;
+  
+  if(baud == 0 || baud >= maxBaud){
+    return baud;                        // no Nextion, or already fast enough
+  }
+  
+  pushCmdArg(maxBaud);
+  sendCmd(F("baud="));
+  delay(50);                            // wait for the last byte to leave and Nextion to change
+  setBaud(maxBaud);
+  if(probe()){
+    return maxBaud;
+  }
+  
+  setBaud(baud);                 // the new rate does not work on this link
+  if(probe()){
+    pushCmdArg(baud);                   // if Nextion changed, it did not hear this. If not, set it back
+    sendCmd(F("baud="));
+    delay(50);
+    return baud;
+  }
+  
+  setBaud(maxBaud);              // Nextion changed but the first check failed, try once more
+  if(probe()){
+    return maxBaud;
+  }
+  setBaud(baud);
+  return 0;
+}
+#if NEXTION_EZ_TASK
+//------------------------------------------------------------------------------
+/*
+ * -- beginTask(unsigned long, int): ESP32 only. Like begin(), and then a FreeRTOS task of the library
+ * calls listen() every 1ms, so the loop (and the WiFi or network code in it) does not have to.
+ * From now on every function takes a mutex, so they can be called from any task or core.
+ * The callbacks of requests, commands, sleep and statistics run in the task of the library.
+ * int = the core of the task (0 or 1). Returns false if the task could not be made.
+ * On a PC build the task is a std::thread and the core is not used.
+ * Syntax: | myObject.beginTask(115200); |
+ */
+bool nextion_ez::beginTask(unsigned long baud, int core){
+#if defined(ESP32)
+  if(_mutex == NULL){
+    _mutex = xSemaphoreCreateRecursiveMutex();
+    if(_mutex == NULL){
+      return false;
+    }
+  }
+  begin(baud);
+  if(_task != NULL){
+    return true;                        // already running
+  }
+  return xTaskCreatePinnedToCore(taskLoop, "nextion_ez", 4096, this, 2, &_task, core) == pdPASS;
+#else
+  (void)core;
+  if(_mutex == NULL){
+    _mutex = new std::recursive_mutex;
+  }
+  begin(baud);
+  if(_task != NULL){
+    return true;
+  }
+  _taskRun = true;
+  _task = new std::thread(taskLoop, this);
+  return true;
+#endif
+}
+//------------------------------------------------------------------------------
+/*
+ * -- endTask(): stops the task of beginTask(), then listen() must be called by the loop again
+ * Syntax: | myObject.endTask(); |
+ */
+void nextion_ez::endTask(){
+#if defined(ESP32)
+  NEX_GUARD();                          // the task is not inside listen() while we hold the mutex
+  if(_task != NULL){
+    vTaskDelete(_task);
+    _task = NULL;
+  }
+#else
+  if(_task != NULL){                    // the thread cannot be killed, it ends after its listen()
+    _taskRun = false;                   // so the mutex must not be held while we wait for it
+    _task->join();
+    delete _task;
+    _task = NULL;
+  }
+#endif
+}
+//------------------------------------------------------------------------------
+/*
+ * -- lock() and unlock(): keep a group of calls together, so no other task comes in between.
+ * Every lock() needs its unlock(). Without beginTask() they do nothing.
+ * Syntax: | myObject.lock(); myObject.pushCmdArg(2); myObject.sendCmd("page"); myObject.unlock(); |
+ */
+void nextion_ez::lock(){
+  if(_mutex != NULL) NEX_LOCK(_mutex);
+}
+
+void nextion_ez::unlock(){
+  if(_mutex != NULL) NEX_UNLOCK(_mutex);
+}
+
+void nextion_ez::taskLoop(void* object){  // the task of beginTask()
+  nextion_ez* nex = static_cast<nextion_ez*>(object);
+#if defined(ESP32)
+  for(;;){
+    nex->listen();
+    vTaskDelay(1);
+  }
+#else
+  while(nex->_taskRun){
+    nex->listen();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+#endif
+}
+#endif
+//------------------------------------------------------------------------------
+/*
+ * -- setBaud(unsigned long): starts a HardwareSerial at this baud rate.
+ * Any other Stream is started by the sketch, before begin().
+ */
+void nextion_ez::setBaud(unsigned long baud){
+  if(_hwSerial != NULL){
+    _hwSerial->begin(baud);
+  }
+}
+//------------------------------------------------------------------------------
+/*
+ * -- probe(): true if Nextion answers "sendme" at the current baud rate
+ */
+bool nextion_ez::probe(){
+  _rxState = NEX_RX_IDLE;
+  txChar(0xFF);                         // end any half command Nextion received at a wrong rate
+  txChar(0xFF);
+  txChar(0xFF);
+  txSend();
+  _txCmdBytes = 0;
+  delay(10);
+  while(_serial->available() > 0){      // forget what came at the wrong rate
+    _serial->read();
+  }
+  rxClear();
+  
+  _gotPage = false;
+  sendCmd(F("sendme"));
+  _tmr1 = millis();
+  while((millis() - _tmr1) < 100UL){    // the reply is 0x66 <page> 0xFF 0xFF 0xFF
+    listen();
+    if(_gotPage){
+      return true;
+    }
+  }
+  return false;
+}
+//------------------------------------------------------------------------------
+int nextion_ez::getCurrentPage(){   //returns the current page id, 0 until Nextion tells an other one
+    NEX_GUARD();
     return _currentPageId;
 }
 //------------------------------------------------------------------------------
 void nextion_ez::setCurrentPage(int page) {  // set the current page id
+    NEX_GUARD();
     _currentPageId = page;
 }
 //------------------------------------------------------------------------------
 int nextion_ez::getLastPage(){      //returns the previous page id 
+    NEX_GUARD();
     return _lastCurrentPageId;
 }
 //------------------------------------------------------------------------------
 void nextion_ez::setLastPage(int page) {  // set the last page id
+    NEX_GUARD();
     _lastCurrentPageId = page;
 }
 //------------------------------------------------------------------------------
 bool nextion_ez::cmdAvail(){        //returns true if commands in the buffer
-    bool avail = _cmdAvail;
-    _cmdAvail = false;
-    return avail;
+    NEX_GUARD();
+    if(_eventCount == 0){
+        return false;
+    }
+    
+    nexEvent* event = &_events[_eventTail];  // the oldest command becomes the one of getCmd() and readByte()
+    memcpy(_cmdBuf, event->data, event->count);
+    _cmdCount = event->count;
+    _cmdRead = 1;
+    _cmdGroup = event->data[0];
+    _cmdLength = event->count;
+    
+    _eventTail++;
+    if(_eventTail >= NEXTION_EZ_EVENTS) _eventTail = 0;
+    _eventCount--;
+    return true;
+}
+//------------------------------------------------------------------------------
+/*
+ * -- onCommand(uint8_t, nextionCommandHandler): a function of yours that listen() calls for every command
+ * of this group, instead of putting it in the queue of cmdAvail(). No switch in the loop is needed.
+ * uint8_t = the command group, the <cmd> byte (example: 'T' for printh 23 02 54 01) or a Nextion
+ * return code like 0x65 (touch event)
+ * nextionCommandHandler = void name(uint8_t group, const uint8_t* data, uint8_t length)
+ * data are the bytes after the group. NULL removes the handler. Up to NEXTION_EZ_HANDLERS groups.
+ * Returns false if the table is full.
+ * Syntax: | myObject.onCommand('T', trigger); |
+ */
+bool nextion_ez::onCommand(uint8_t group, nextionCommandHandler handler){
+    NEX_GUARD();
+    for(uint8_t i = 0; i < _handlerCount; i++){
+        if(_handlers[i].group == group){
+            if(handler == NULL){
+                _handlers[i] = _handlers[--_handlerCount];
+            }else{
+                _handlers[i].handler = handler;
+            }
+            return true;
+        }
+    }
+    if(handler == NULL){
+        return true;
+    }
+    if(_handlerCount >= NEXTION_EZ_HANDLERS){
+        return false;
+    }
+    _handlers[_handlerCount].group = group;
+    _handlers[_handlerCount].handler = handler;
+    _handlerCount++;
+    return true;
+}
+//------------------------------------------------------------------------------
+/*
+ * -- pendingEvents(): the commands waiting in the queue of cmdAvail()
+ * Syntax: | int count = myObject.pendingEvents(); |
+ */
+int nextion_ez::pendingEvents(){
+    NEX_GUARD();
+    return _eventCount;
+}
+//------------------------------------------------------------------------------
+/*
+ * -- addEvent(uint8_t): the command in _rxCmd has arrived, with uint8_t bytes. It goes to its handler
+ * or to the queue, which keeps NEXTION_EZ_EVENTS commands, so a burst is not lost when
+ * cmdAvail() is called late. When the queue is full the new command is lost.
+ */
+void nextion_ez::addEvent(uint8_t count){
+    uint8_t kept = (count < NEXTION_EZ_CMD_MAX) ? count : NEXTION_EZ_CMD_MAX;
+    for(uint8_t i = 0; i < _handlerCount; i++){
+        if(_handlers[i].group == _rxCmd[0]){
+            _handlers[i].handler(_rxCmd[0], &_rxCmd[1], kept - 1);
+            return;
+        }
+    }
+    
+    if(_eventCount >= NEXTION_EZ_EVENTS){
+        NEX_STAT(_stats.lostEvents++);
+        return;
+    }
+    uint8_t slot = _eventTail + _eventCount;
+    if(slot >= NEXTION_EZ_EVENTS) slot -= NEXTION_EZ_EVENTS;
+    memcpy(_events[slot].data, _rxCmd, kept);
+    _events[slot].count = kept;         // the bytes past NEXTION_EZ_CMD_MAX are gone, only the kept ones count
+    _eventCount++;
 }
 //------------------------------------------------------------------------------
 int nextion_ez::getCmd(){           //returns the 1st command byte 
+    NEX_GUARD();
     return _cmdGroup;
 }
 //------------------------------------------------------------------------------
-int nextion_ez::getCmdLen(){        //'returns the number of command bytes (for use in custom commands)
+int nextion_ez::getCmdLen(){        //'returns the number of command bytes kept, up to NEXTION_EZ_CMD_MAX
+    NEX_GUARD();
     return _cmdLength;
 }
 //------------------------------------------------------------------------------
@@ -76,26 +513,146 @@ int nextion_ez::getCmdLen(){        //'returns the number of command bytes (for
  * uint32_t = value (example: 84)
  * Syntax: | myObject.writeNum("n0.val", 765);  |  or  | myObject.writeNum("n0.bco", 17531);       |
  *         | set the value of numeric n0 to 765 |      | set background color of n0 to 17531 (blue)|
+ * The name can also be a plain text (char array) or a text stored in flash with F("n0.val").
+ * These never use the heap memory, which matters when they are called many times per second.
+ * The fastest is a handle made with NEX_COMPONENT(), see nextion_ez.h
  */
-void nextion_ez::writeNum(String compName, uint32_t val){
-	_component = compName;
-	_numVal = val;
-  
-	_serial->print(_component);
-    _serial->print("=");
-    _serial->print(_numVal);
-	_serial->print("\xFF\xFF\xFF");
+void nextion_ez::writeNum(const String& compName, uint32_t val){
+    NEX_GUARD();
+    writeNum(compName.c_str(), val);
+}
+
+void nextion_ez::writeNum(const char* compName, uint32_t val){
+    NEX_GUARD();
+    uint32_t key = hashText(compName);
+    if(deferNum(key, NULL, compName, false, val) || cacheSame(key, val)){
+        return;                         // its page is not shown, or Nextion already shows this value
+    }
+    txText(compName);
+    txChar('=');
+    txNumber(val);
+    txEnd();
+}
+
+void nextion_ez::writeNum(const __FlashStringHelper* compName, uint32_t val){  // name stored in flash with F()
+    NEX_GUARD();
+    uint32_t key = hashText(compName);
+    if(deferNum(key, NULL, reinterpret_cast<const char*>(compName), true, val) || cacheSame(key, val)){
+        return;
+    }
+    txText(compName);
+    txChar('=');
+    txNumber(val);
+    txEnd();
+}
+
+void nextion_ez::writeNum(const nextionComponent& comp, uint32_t val){  // handle made with NEX_COMPONENT()
+    NEX_GUARD();
+    if(deferNum(comp.key, &comp, NULL, false, val) || cacheSame(comp.key, val)){
+        return;
+    }
+    txFlash(comp.set, comp.length + 1);   // "n0.val=" is ready, only the number is made here
+    txNumber(val);
+    txEnd();
+}
+//------------------------------------------------------------------------------
+/*
+ * -- writeInt(String, int32_t): the same as writeNum(), for signed values. writeNum() sends -5 as 4294967291
+ * int32_t = value (example: -40)
+ * Syntax: | myObject.writeInt("n0.val", -40); |
+ * The name can also be a char array, F("n0.val") or a handle made with NEX_COMPONENT()
+ */
+void nextion_ez::writeInt(const String& compName, int32_t val){
+    NEX_GUARD();
+    writeInt(compName.c_str(), val);
+}
+
+void nextion_ez::writeInt(const char* compName, int32_t val){
+    NEX_GUARD();
+    uint32_t key = hashText(compName);
+    if(deferNum(key, NULL, compName, false, (uint32_t)val, NEX_PAGED_INT) || cacheSame(key, (uint32_t)val)){
+        return;
+    }
+    txText(compName);
+    txChar('=');
+    txSigned(val);
+    txEnd();
+}
+
+void nextion_ez::writeInt(const __FlashStringHelper* compName, int32_t val){
+    NEX_GUARD();
+    uint32_t key = hashText(compName);
+    if(deferNum(key, NULL, reinterpret_cast<const char*>(compName), true, (uint32_t)val, NEX_PAGED_INT) || cacheSame(key, (uint32_t)val)){
+        return;
+    }
+    txText(compName);
+    txChar('=');
+    txSigned(val);
+    txEnd();
+}
+
+void nextion_ez::writeInt(const nextionComponent& comp, int32_t val){
+    NEX_GUARD();
+    if(deferNum(comp.key, &comp, NULL, false, (uint32_t)val, NEX_PAGED_INT) || cacheSame(comp.key, (uint32_t)val)){
+        return;
+    }
+    txFlash(comp.set, comp.length + 1);
+    txSigned(val);
+    txEnd();
+}
+//------------------------------------------------------------------------------
+/*
+ * -- writeFixed(String, float, uint8_t): a float for an Xfloat component. Xfloat shows an integer
+ * with a decimal point before its last vvs1 digits, so the value is sent multiplied by 10 for each decimal
+ * float = value (example: 23.47)
+ * uint8_t = decimals, the same as vvs1 of the Xfloat (example: 1, then 23.47 is sent as 235 and shown as 23.5)
+ * Syntax: | myObject.writeFixed("x0.val", temperature, 1); |
+ * The float is only multiplied and rounded, it is never printed, so it is fast also on 8 bit boards.
+ * Values beyond the int32 range are sent as its largest or smallest value, NaN as 0
+ */
+static int32_t nexFixed(float value, uint8_t decimals){
+    while(decimals > 0){
+        value *= 10.0f;
+        decimals--;
+    }
+    if(value != value) return 0;                      // NaN, it has no integer
+    if(value >= 2147483647.0f) return 2147483647L;   // the largest an Xfloat can show
+    if(value <= -2147483648.0f) return -2147483647L - 1;
+    return (int32_t)(value < 0 ? value - 0.5f : value + 0.5f);
+}
+
+void nextion_ez::writeFixed(const String& compName, float val, uint8_t decimals){
+    NEX_GUARD();
+    writeInt(compName.c_str(), nexFixed(val, decimals));
+}
+
+void nextion_ez::writeFixed(const char* compName, float val, uint8_t decimals){
+    NEX_GUARD();
+    writeInt(compName, nexFixed(val, decimals));
+}
+
+void nextion_ez::writeFixed(const __FlashStringHelper* compName, float val, uint8_t decimals){
+    NEX_GUARD();
+    writeInt(compName, nexFixed(val, decimals));
+}
+
+void nextion_ez::writeFixed(const nextionComponent& comp, float val, uint8_t decimals){
+    NEX_GUARD();
+    writeInt(comp, nexFixed(val, decimals));
 }
 //------------------------------------------------------------------------------
 /*
  * -- writeByte(uint8_t): Main purpose and usage is for sending the raw data required by the addt command
  * Where we need to write raw bytes to serial 
+ * For waveforms, streamWave() does the whole addt exchange for you
  * uint8_t = raw byte value (0-255 or 0x00-0xFF)
  * Syntax: | myObject.writeByte(0);  |  or  | myObject.writeByte(0xA0);  |
  */
 
 void  nextion_ez::writeByte(uint8_t val){
-    _serial->write(val);
+    NEX_GUARD();
+    txChar(val);
+    if(!_txHold) txSend();
 }
 //------------------------------------------------------------------------------
 /*
@@ -108,6 +665,7 @@ void  nextion_ez::writeByte(uint8_t val){
  */
 //------------------------------------------------------------------------------
 void nextion_ez::pushCmdArg(uint32_t argument){
+    NEX_GUARD();
     _cmdFifo[_cmdFifoHead] = argument;
     _cmdFifoHead++;
     if (_cmdFifoHead > 15) _cmdFifoHead = 0;
@@ -120,9 +678,32 @@ void nextion_ez::pushCmdArg(uint32_t argument){
  *                                                   myObject.pushCmdArg(3);
  * Syntax: | myObject.sendCmd("page 1");   |  or  | myObject.sendCmd("repo va0,"); |
  *         | change to page 1            |      |  Refresh component with the id of 3  |
+ * The command can also be a char array, a char array with its length, or a text in flash with F()
  */
-void nextion_ez::sendCmd(String command){ 
-	_component = command;
+void nextion_ez::sendCmd(const String& command){ 
+    NEX_GUARD();
+    sendCmd(command.c_str(), command.length());
+}
+
+void nextion_ez::sendCmd(const char* command){ 
+    NEX_GUARD();
+    txText(command);
+    sendCmdArgs();
+}
+
+void nextion_ez::sendCmd(const char* command, size_t length){  // command that is not '\0' terminated
+    NEX_GUARD();
+    txText(command, length);
+    sendCmdArgs();
+}
+
+void nextion_ez::sendCmd(const __FlashStringHelper* command){  // command stored in flash with F()
+    NEX_GUARD();
+    txText(command);
+    sendCmdArgs();
+}
+//------------------------------------------------------------------------------
+void nextion_ez::sendCmdArgs(){         // sends the arguments of the FIFO and the end of the command
 	uint8_t _count;
     uint8_t x;
     uint32_t _argument = 0;
@@ -133,19 +714,16 @@ void nextion_ez::sendCmd(String command){
         _count = _cmdFifoHead - _cmdFifoTail;
     }
 
-    _serial->print(_component);
-
     if(_count > 0) {
-        //_serial->print(" ");                     
         for (x = 0; x < _count; x++) {
-            if (x > 0) _serial->print(",");         // only need commas between arguments, not between command and 1st argument
+            if (x > 0) txChar(',');                 // only need commas between arguments, not between command and 1st argument
             _argument = _cmdFifo[_cmdFifoTail];
-            _serial->print(_argument);
+            txNumber(_argument);
             _cmdFifoTail++;
             if(_cmdFifoTail > 15) _cmdFifoTail = 0;
         }
     }
-    _serial->print("\xFF\xFF\xFF");
+    txEnd();
 }
 //------------------------------------------------------------------------------
 /*
@@ -157,242 +735,1883 @@ void nextion_ez::sendCmd(String command){
  *         | add a value of 255 to channel 1 of waveform with id 5 |     
  */
 void nextion_ez::addWave(uint8_t id, uint8_t channel, uint8_t val){ 
-    _serial->print("add ");
-    _serial->print(id);
-    _serial->print(",");
-    _serial->print(channel);
-    _serial->print(",");
-    _serial->print(val);
-    _serial->print("\xFF\xFF\xFF");
+    NEX_GUARD();
+    txText("add ");
+    txNumber(id);
+    txChar(',');
+    txNumber(channel);
+    txChar(',');
+    txNumber(val);
+    txEnd();
 }
 //------------------------------------------------------------------------------
 /*
- * -- writeStr(String, String): for writing in components' text attributes
- * String No1 = objectname.textAttribute (example: "t0.txt"  or "b0.txt")
- * String No2 = value (example: "Hello World")
- * Syntax: | myObject.writeStr("t0.txt", "Hello World");  |  or  | myObject.writeNum("b0.txt", "Button0"); |
- *         | set the value of textbox t0 to "Hello World" |      | set the text of button b0 to "Button0"  |
+ * -- streamWave(uint8_t, uint8_t, uint8_t): like addWave(), but much faster for many values
+ * uint8_t No1 = id number of the waveform object (id number not name)
+ * uint8_t No2 = channel number to update
+ * uint8_t No3 = value to add to the channel
+ * The values are kept in a buffer for each channel. When NEXTION_EZ_WAVE_BLOCK values are waiting,
+ * listen() sends them all together with the Nextion "addt" command, as raw bytes.
+ * "add 1,0,255" costs 14 bytes for each value, with addt each value costs about 2 bytes.
+ * Up to NEXTION_EZ_WAVE_CHANNELS channels can be streamed, with more (or with 0) the values go with addWave().
+ * Returns false if the buffer of the channel is full and the value was not kept.
+ * Syntax: | myObject.streamWave(5, 1, 255);  |  and call listen() often
  */
-void nextion_ez::writeStr(String command, String txt){ 
-	_component = command;
-	_strVal = txt;
-  
-    _serial->print(_component);
-    _serial->print("=\"");
-    _serial->print(_strVal);
-    _serial->print("\"");
-    _serial->print("\xFF\xFF\xFF");
+bool nextion_ez::streamWave(uint8_t id, uint8_t channel, uint8_t val){
+    NEX_GUARD();
+    waveChannel* wave = findWave(id, channel, true);
+    if(wave == NULL){                   // no free buffer, send the value the slow way
+        addWave(id, channel, val);
+        return true;
+    }
+    if(wave->count >= NEXTION_EZ_WAVE_SIZE){
+        return false;                   // the buffer is full
+    }
+    wavePut(wave, val);
+    return true;
 }
 //------------------------------------------------------------------------------
-String nextion_ez::readStr(String TextComponent){
-  
-  String _Textcomp = TextComponent;  
-  bool _endOfCommandFound = false;
-  char _tempChar;
-  
-    _tmr1 = millis();  
-  while(_serial->available()){                  // Waiting for NO bytes on Serial, 
-                                                    // as other commands could be sent in that time.
-    if((millis() - _tmr1) > 1000UL){                // Waiting... But not forever...after the timeout 
-      _readString = "ERROR";
-      break;                                // Exit from the loop due to timeout. Return ERROR
-    }else{
-      listen();                      // We run listen(), in case that the bytes on Serial are a part of a command 
+/*
+ * -- setWaveDecimation(id, channel, samples, mode, inputMax): for signals sampled much faster than the
+ * waveform can draw. sampleWave() then takes every sample, and only one column of the waveform
+ * is sent for each "samples" of them, to streamWave(). Nextion draws one pixel for each value, so:
+ * samples = samples per second / pixels per second of the waveform (example: 10000 / 100 = 100)
+ * uint8_t mode = NEX_WAVE_MEAN: the mean of the samples, one pixel for each column
+ *                NEX_WAVE_MINMAX: the lowest and the highest sample, in the order they came, two pixels
+ *                for each column, so a fast signal is shown as its envelope (use samples / 2 for the same speed)
+ * uint16_t inputMax = the largest sample, scaled to 255 (example: 1023 for a 10 bit analogRead(), 4095 for 12 bit)
+ * samples 0 stops the decimation. Returns false if no buffer of NEXTION_EZ_WAVE_CHANNELS is free (always with 0).
+ * Syntax: | myObject.setWaveDecimation(1, 0, 50, NEX_WAVE_MINMAX, 1023); |
+ */
+bool nextion_ez::setWaveDecimation(uint8_t id, uint8_t channel, uint16_t samples, uint8_t mode, uint16_t inputMax){
+    NEX_GUARD();
+    waveChannel* wave = findWave(id, channel, true);
+    if(wave == NULL){
+        return false;
     }
-  }
-  
-  // As there are NO bytes left in Serial, which means no further commands need to be executed,
-  // send a "get" command to Nextion
-  
-  _serial->print("get ");
-  _serial->print(_Textcomp);             // The String of a component you want to read on Nextion
-	_serial->print("\xFF\xFF\xFF");
-  
-  // And now we are waiting for a reurn data in the following format:
-  // 0x70 ... (each character of the String is represented in HEX) ... 0xFF 0xFF 0xFF
-  
-  // Example: For the String ab123, we will receive: 0x70 0x61 0x62 0x31 0x32 0x33 0xFF 0xFF 0xFF
-  
-  _tmr1 = millis();  
-  while(_serial->available() < 4){                  // Waiting for bytes to come to Serial, an empty Textbox will send 4 bytes 
-                                                    // and this the minimmum number that we are waiting for (70 FF FF FF)
-    if((millis() - _tmr1) > 400UL){                // Waiting... But not forever...after the timeout 
-       _readString = "ERROR";
-       break;                        // Exit the loop due to timeout. Return ERROR
+    wave->every = samples;
+    wave->mode = mode;
+    wave->inputMax = (inputMax > 0) ? inputMax : 1;
+    wave->seen = 0;
+    return true;
+}
+//------------------------------------------------------------------------------
+/*
+ * -- sampleWave(uint8_t, uint8_t, uint16_t): a sample for a channel set with setWaveDecimation().
+ * Each sample is only compared and added, the column is made when enough samples have come.
+ * Returns false if the channel has no decimation, or if the buffer was full and the column was lost.
+ * Syntax: | myObject.sampleWave(1, 0, analogRead(A0)); |  and call listen() often
+ */
+bool nextion_ez::sampleWave(uint8_t id, uint8_t channel, uint16_t val){
+    NEX_GUARD();
+    waveChannel* wave = findWave(id, channel, false);
+    if(wave == NULL || wave->every == 0){
+        return false;
     }
-  }
-  
-  if(_serial->available() > 3){         // Read if more then 3 bytes come (we always wait for more than 3 bytes)
-    _start_char = _serial->read();      //  variable (start_char) read and store the first byte on it  
-    _tmr1 = millis();
-      
-    while(_start_char != 0x70){      // If the return code 0x70 is not detected,
-      if(_serial->available()){      // read the Serial until you find it
-        _start_char = _serial->read();
-      }
-        
-      if((millis() - _tmr1) > 100UL){     // Waiting... But not forever...... 
-        _readString = "ERROR";          // If the 0x70 is not found within the given time, break the while()
-                                        // to avoid being stuck inside the while() loop
-        break;
-      }   
+    if(wave->seen == 0){
+        wave->low = val;
+        wave->high = val;
+        wave->sum = 0;
+        wave->lowFirst = true;
+    }else if(val < wave->low){
+        wave->low = val;
+        wave->lowFirst = false;         // the lowest came after the highest
+    }else if(val > wave->high){
+        wave->high = val;
+        wave->lowFirst = true;
     }
-      
-    if(_start_char == 0x70){  // If the return code 0x70 is detected,   
-      _readString = "";   // We clear the _readString variable, to avoid any accidentally stored text
-      int _endBytes = 0;  // This variable helps us count the end command bytes of Nextion. The 0xFF 0xFF 0xFF
-      _tmr1 = millis(); 
-      
-      while(_endOfCommandFound == false){  // As long as the three 0xFF bytes have NOT been found, run the commands inside the loop
-        if(_serial->available()){
-          _tempChar = _serial->read();  // Read the first byte of the Serial
-         
-          if(_tempChar == 0xFF || _tempChar == 0xFFFFFFFF){  // If the read byte is the end command byte, 
-            _endBytes++ ;      // Add one to the _endBytes counter
-            if(_endBytes == 3){  
-              _endOfCommandFound = true;  // If the counter is equal to 3, we have the end command
-            }                         
-          }else{ // If the read byte is NOT the end command byte,
-            _readString += _tempChar;  // Add the char to the _readString String variable 
-          }
-        }
-          
-        if((millis() - _tmr1) > 1000UL){     // Waiting... But not forever...... 
-          _readString = "ERROR";           // If the end of the command is NOT found in the time given,
-                                           // break the while
-          break;                           
-        }
-      }
+    wave->sum += val;
+    if(++wave->seen < wave->every){
+        return true;
     }
-  } 
+    wave->seen = 0;                     // the column is complete
 
-  return _readString;
+    if(wave->mode == NEX_WAVE_MINMAX){
+        if(wave->count + 2 > NEXTION_EZ_WAVE_SIZE){
+            return false;
+        }
+        wavePut(wave, waveScale(wave, wave->lowFirst ? wave->low : wave->high));
+        wavePut(wave, waveScale(wave, wave->lowFirst ? wave->high : wave->low));
+    }else{
+        if(wave->count >= NEXTION_EZ_WAVE_SIZE){
+            return false;
+        }
+        wavePut(wave, waveScale(wave, wave->sum / wave->every));
+    }
+    return true;
 }
 //------------------------------------------------------------------------------
 /*
- * -- readNumber(String): We use it to read the value of a components' numeric attribute on Nextion
- * In every component's numeric attribute (value, bco color, pco color...etc)
- * String = objectname.numericAttribute (example: "n0.val", "n0.pco", "n0.bco"...etc)
- * Syntax: | myObject.readNumber("n0.val"); |  or  | myObject.readNumber("b0.bco");                       |
- *         | read the value of numeric n0   |      | read the color number of the background of butoon b0 |
+ * -- findWave(), wavePut(), waveScale(): the buffer of a channel (with create, a free one is taken for a new channel;
+ * NULL if there is none), a value added to it, and a sample scaled from 0..inputMax to 0..255
  */
-
-uint32_t nextion_ez::readNum(String component){
-  
-  _comp = component;
-  bool _endOfCommandFound = false;
-  char _tempChar;
-  
-    _numberValue = 777777;                      // The function will return this number in case it fails to read the new number
-  
-    _tmr1 = millis();  
-  while(_serial->available()){                  // Waiting for NO bytes on Serial, 
-                                                    // as other commands could be sent in that time.
-    if((millis() - _tmr1) > 1000UL){                // Waiting... But not forever...after the timeout 
-      _numberValue = 777777;
-      break;                                // Exit from the loop due to timeout. Return 777777
-    }else{
-      listen();                      // We run listen(), in case that the bytes on Serial are a part of a command 
+nextion_ez::waveChannel* nextion_ez::findWave(uint8_t id, uint8_t channel, bool create){
+#if NEXTION_EZ_WAVE_CHANNELS > 0
+    waveChannel* unused = NULL;
+    for(uint8_t i = 0; i < NEXTION_EZ_WAVE_CHANNELS; i++){
+        if(!_wave[i].used){
+            if(unused == NULL) unused = &_wave[i];
+        }else if(_wave[i].id == id && _wave[i].channel == channel){
+            return &_wave[i];
+        }
     }
-  }
-  
-  
-  // As there are NO bytes left in Serial, which means no further commands need to be executed,
-  // send a "get" command to Nextion
-  
-  _serial->print("get ");
-  _serial->print(_comp);             // The String of a component you want to read on Nextion
-	_serial->print("\xFF\xFF\xFF");
-  
-  // And now we are waiting for a reurn data in the following format:
-  // 0x71 0x01 0x02 0x03 0x04 0xFF 0xFF 0xFF
-  // 0x01 0x02 0x03 0x04 is 4 byte 32-bit value in little endian order.
-
-    _tmr1 = millis();  
-  while(_serial->available() < 8){                  // Waiting for bytes to come to Serial, 
-                                                    // we are waiting for 8 bytes
-    if((millis() - _tmr1) > 400UL){                // Waiting... But not forever...after the timeout 
-       _numberValue = 777777;
-       break;                                  // Exit the loop due to timeout. Return 777777
+    if(!create){
+        return NULL;
     }
-  }
-  
-  if(_serial->available() > 7){         
-    _start_char = _serial->read();      //  variable (start_char) read and store the first byte on it  
-    _tmr1 = millis();
-      
-    while(_start_char != 0x71){      // If the return code 0x71 is not detected,
-      if(_serial->available()){      // read the Serial until you find it
-        _start_char = _serial->read();
-      }
-        
-      if((millis() - _tmr1) > 100UL){     // Waiting... But not forever...... 
-        _numberValue = 777777;          // If the 0x71 is not found within the given time, break the while()
-                                        // to avoid being stuck inside the while() loop
-        break;
-      }   
+    if(unused != NULL){
+        unused->used = true;
+        unused->id = id;
+        unused->channel = channel;
+        unused->head = 0;
+        unused->count = 0;
+        unused->every = 0;
+        unused->fails = 0;
     }
-      
-    if(_start_char == 0x71){  // If the return code 0x71 is detected, 
-  
-			for(int i = 0; i < 4; i++){   // Read the 4 bytes represent the number and store them in the numeric buffer 
-		   
-        _numericBuffer[i] = _serial->read();
-	    }
-      
-      
-      int _endBytes = 0;  // This variable helps us count the end command bytes of Nextion. The 0xFF 0xFF 0xFF
-      _tmr1 = millis();  
-      
-      while(_endOfCommandFound == false){  // As long as the three 0xFF bytes have NOT been found, run the commands inside the loop
-        
-        _tempChar = _serial->read();  // Read the next byte of the Serial
-         
-        if(_tempChar == 0xFF || _tempChar == 0xFFFFFFFF){  // If the read byte is the end command byte, 
-          _endBytes++ ;      // Add one to the _endBytes counter
-          if(_endBytes == 3){  
-            _endOfCommandFound = true;  // If the counter is equal to 3, we have the end command
-          }                         
-        }else{ // If the read byte is NOT the end command byte,
-          _numberValue = 777777;
-          break;            
-        }
-          
-        if((millis() - _tmr1) > 1000UL){     // Waiting... But not forever...... 
-          _numberValue = 777777;           // If the end of the command is NOT found in the time given,
-                                           // break the while
-          break;                           
-        }
-      }
+    return unused;
+#else
+    (void)id;
+    (void)channel;
+    (void)create;
+    return NULL;                        // no buffer, streamWave() sends with add
+#endif
+}
+
+void nextion_ez::wavePut(waveChannel* wave, uint8_t val){
+    uint8_t place = wave->head + wave->count;
+    if(place >= NEXTION_EZ_WAVE_SIZE) place -= NEXTION_EZ_WAVE_SIZE;
+    wave->data[place] = val;
+    wave->count++;
+}
+
+uint8_t nextion_ez::waveScale(waveChannel* wave, uint32_t val){
+    if(val >= wave->inputMax){
+        return 255;
     }
-  }
-  
-  if(_endOfCommandFound == true){
-    // We can continue with the little endian conversion
-    _numberValue = _numericBuffer[3];
-    _numberValue <<= 8;
-    _numberValue |= _numericBuffer[2];
-    _numberValue <<= 8;
-    _numberValue |= _numericBuffer[1];
-    _numberValue <<= 8;
-    _numberValue |= _numericBuffer[0];
-  }else{
-    _numberValue = 777777;
-  }
-  
-  return _numberValue;
+    if(wave->inputMax == 255){
+        return val;                     // already 0..255, no division
+    }
+    return (val * 255UL) / wave->inputMax;  // one division for each column, not for each sample
 }
 //------------------------------------------------------------------------------
 /*
- * -- readByte(): Main purpose and usage is for the custom commands read
- * Where we need to read bytes from Serial inside user code
+ * -- sendWave(): the values of streamWave() are sent by listen() even if less than a block
+ * Syntax: | myObject.sendWave();  |
  */
-
-int  nextion_ez::readByte(){
+void nextion_ez::sendWave(){
+    NEX_GUARD();
+    _waveFlush = true;
+}
+//------------------------------------------------------------------------------
+/*
+ * -- startWave(): sends "addt id,channel,count" for the next channel with enough values.
+ * Nextion answers 0xFE when it is ready for the raw data, then readReply() calls sendWaveData().
+ * A channel whose addt failed waits 0.5 s before the next try, twice as long after each failure, up to 8 s.
+ */
+void nextion_ez::startWave(){
+    if(_txHold || _txWaiting){
+        return;                         // wait for the end of the batch (see beginBatch()) or of the block txSend() waits for
+    }
+
+#if NEXTION_EZ_WAVE_CHANNELS > 0
+    for(uint8_t i = 0; i < NEXTION_EZ_WAVE_CHANNELS; i++){
+        uint8_t slot = (_waveNext + i) % NEXTION_EZ_WAVE_CHANNELS;
+        waveChannel* wave = &_wave[slot];
+        if(wave->fails > 0 && (millis() - wave->failTime) < (500UL << (wave->fails - 1))){
+            continue;                   // its addt failed not long ago
+        }
+        if(wave->used && (wave->count >= NEXTION_EZ_WAVE_BLOCK || (_waveFlush && wave->count > 0))){
+            _waveSlot = slot;
+            _waveCount = wave->count;   // values added from now on go with the next block
+            _waveNext = slot + 1;
+
+            uint8_t priority = _txPriority;
+            _txPriority = NEX_PRIO_HIGH; // addt must go now, Nextion answers it with 0xFE
+            txText("addt ");
+            txNumber(wave->id);
+            txChar(',');
+            txNumber(wave->channel);
+            txChar(',');
+            txNumber(_waveCount);
+            txEnd(NEX_ACK_NONE);        // addt answers with 0xFE and 0xFD, not 0x01
+            _txPriority = priority;
+
+            _waveState = NEX_WAVE_READY;
+            _waveTime = millis();
+            return;
+        }
+    }
+#endif
+    _waveFlush = false;                 // every channel is empty
+}
+//------------------------------------------------------------------------------
+/*
+ * -- waveFailed(): the addt of the block got an error or no answer. The block is given up, the values stay
+ * in the buffer, and the channel waits before its next try, so a wrong id does not send addt all the time.
+ */
+void nextion_ez::waveFailed(){
+#if NEXTION_EZ_WAVE_CHANNELS > 0
+    waveChannel* wave = &_wave[_waveSlot];
+    if(wave->fails < 5) wave->fails++;
+    wave->failTime = millis();
+#endif
+    _waveState = NEX_WAVE_IDLE;
+    txSend();                           // the commands that waited for the block
+}
+//------------------------------------------------------------------------------
+/*
+ * -- sendWaveData(): the raw bytes after the 0xFE of Nextion, straight to the Serial
+ */
+void nextion_ez::sendWaveData(){
+#if NEXTION_EZ_WAVE_CHANNELS > 0
+    waveChannel* wave = &_wave[_waveSlot];
+    uint8_t first = NEXTION_EZ_WAVE_SIZE - wave->head;  // the part up to the end of the ring buffer
+    if(first > _waveCount) first = _waveCount;
+    txWrite(&wave->data[wave->head], first);
+    if(_waveCount > first){
+        txWrite(&wave->data[0], _waveCount - first);
+    }
+    NEX_STAT(_stats.txBytes += _waveCount);
+
+    wave->head += _waveCount;
+    if(wave->head >= NEXTION_EZ_WAVE_SIZE) wave->head -= NEXTION_EZ_WAVE_SIZE;
+    wave->count -= _waveCount;
+    wave->fails = 0;
+#endif
+
+    _waveState = NEX_WAVE_DONE;         // now we wait for 0xFD
+    _waveTime = millis();
+    txSend();                           // the commands that waited for the data
+}
+//------------------------------------------------------------------------------
+/*
+ * -- writeStr(String, String): for writing in components' text attributes
+ * String No1 = objectname.textAttribute (example: "t0.txt"  or "b0.txt")
+ * String No2 = value (example: "Hello World")
+ * Syntax: | myObject.writeStr("t0.txt", "Hello World");  |  or  | myObject.writeNum("b0.txt", "Button0"); |
+ *         | set the value of textbox t0 to "Hello World" |      | set the text of button b0 to "Button0"  |
+ * Both can also be char arrays (the text optionally with its length) or texts in flash with F(),
+ * these never use the heap memory
+ */
+void nextion_ez::writeStr(const String& command, const String& txt){ 
+    NEX_GUARD();
+    writeStr(command.c_str(), txt.c_str(), txt.length());
+}
+
+void nextion_ez::writeStr(const char* command, const char* txt){ 
+    NEX_GUARD();
+    writeStr(command, txt, strlen(txt));
+}
+
+void nextion_ez::writeStr(const char* command, const char* txt, size_t length){  // text that is not '\0' terminated
+    NEX_GUARD();
+    uint32_t key = hashText(command);
+    if(deferStr(key, NULL, command, false, txt, length, false) || cacheSame(key, hashText(txt, length))){
+        return;                         // its page is not shown, or Nextion already shows this text
+    }
+    txText(command);
+    txText("=\"");
+    txText(txt, length);
+    txChar('"');
+    txEnd();
+}
+
+void nextion_ez::writeStr(const __FlashStringHelper* command, const char* txt){  // name stored in flash with F()
+    NEX_GUARD();
+    uint32_t key = hashText(command);
+    if(deferStr(key, NULL, reinterpret_cast<const char*>(command), true, txt, strlen(txt), false) || cacheSame(key, hashText(txt))){
+        return;
+    }
+    txText(command);
+    txText("=\"");
+    txText(txt);
+    txChar('"');
+    txEnd();
+}
+
+void nextion_ez::writeStr(const __FlashStringHelper* command, const __FlashStringHelper* txt){  // both stored in flash
+    NEX_GUARD();
+    uint32_t key = hashText(command);
+    const char* p = reinterpret_cast<const char*>(txt);
+    if(deferStr(key, NULL, reinterpret_cast<const char*>(command), true, p, strlen_P(p), true) || cacheSame(key, hashText(txt))){
+        return;
+    }
+    txText(command);
+    txText("=\"");
+    txText(txt);
+    txChar('"');
+    txEnd();
+}
+
+void nextion_ez::writeStr(const nextionComponent& comp, const char* txt){  // handle made with NEX_COMPONENT()
+    NEX_GUARD();
+    if(deferStr(comp.key, &comp, NULL, false, txt, strlen(txt), false) || cacheSame(comp.key, hashText(txt))){
+        return;
+    }
+    txFlash(comp.set, comp.length + 1);
+    txChar('"');
+    txText(txt);
+    txChar('"');
+    txEnd();
+}
+//------------------------------------------------------------------------------
+/*
+ * -- useCache(bool): with true, writeNum() and writeStr() remember the last value sent to each
+ * component and do not send it again if it has not changed. Saves a lot of Serial time
+ * when the same values are written in every loop.
+ * The values are forgotten when a new page is loaded ('P' command or sendme reply), as Nextion
+ * shows the values of the HMI file again, and when Nextion answers with an error. A value counts
+ * only once it is sent. Up to NEXTION_EZ_CACHE components are remembered. With NEXTION_EZ_CACHE 0 it does nothing.
+ * Syntax: | myObject.useCache(true); |
+ */
+void nextion_ez::useCache(bool on){
+    NEX_GUARD();
+#if NEXTION_EZ_CACHE > 0
+    _cacheOn = on;
+    clearCache();
+#else
+    (void)on;                           // no room for the values, every write is sent
+#endif
+}
+//------------------------------------------------------------------------------
+/*
+ * -- clearCache(): forgets all the remembered values, so the next write of every component is sent
+ * clearCache(char array): forgets the value of one component, so its next write is sent even if the same
+ * Syntax: | myObject.clearCache(); |  or  | myObject.clearCache("n0.val"); |
+ */
+void nextion_ez::clearCache(){
+    NEX_GUARD();
+#if NEXTION_EZ_CACHE > 0
+    for(uint8_t i = 0; i < NEXTION_EZ_CACHE; i++){
+        _cache[i].state = NEX_CACHE_FREE;
+    }
+#endif
+}
+
+void nextion_ez::clearCache(const char* compName){
+    NEX_GUARD();
+    cacheForget(hashText(compName));
+}
+//------------------------------------------------------------------------------
+/*
+ * -- onPage(nextionComponent, uint8_t): tells the library on which page a component is (a handle made with NEX_COMPONENT()).
+ * While an other page is shown, writeNum() and writeStr() of this component are not sent, as Nextion
+ * would only answer with an error. The last value is kept and sent, together with the others, when
+ * its page is loaded ('P' command or sendme reply). Up to NEXTION_EZ_PAGED components.
+ * Texts are kept only if they fit in NEXTION_EZ_PAGED_TEXT characters, otherwise they are sent as before.
+ * Returns false if the table is full. With NEXTION_EZ_PAGED 0 it does nothing and returns false.
+ * Syntax: | myObject.onPage(speed, 2); |
+ */
+bool nextion_ez::onPage(const nextionComponent& comp, uint8_t page){
+    NEX_GUARD();
+#if NEXTION_EZ_PAGED > 0
+    pagedEntry* entry = findPaged(comp.key);
+    if(entry == NULL){
+        if(_pagedCount >= NEXTION_EZ_PAGED){
+            return false;
+        }
+        entry = &_paged[_pagedCount++];
+        entry->comp = &comp;
+        entry->key = comp.key;
+        entry->state = NEX_PAGED_NONE;
+    }
+    entry->page = page;
+    return true;
+#else
+    (void)comp;
+    (void)page;
+    return false;
+#endif
+}
+//------------------------------------------------------------------------------
+/*
+ * -- clearPages(): forgets the pages of all components and the values they keep, every write is sent again
+ * Syntax: | myObject.clearPages(); |
+ */
+void nextion_ez::clearPages(){
+    NEX_GUARD();
+    _pagedCount = 0;
+}
+//------------------------------------------------------------------------------
+/*
+ * -- findPaged(uint32_t): the entry of onPage() for this component, or NULL
+ */
+nextion_ez::pagedEntry* nextion_ez::findPaged(uint32_t key){
+#if NEXTION_EZ_PAGED > 0
+    for(uint8_t i = 0; i < _pagedCount; i++){
+        if(_paged[i].key == key){
+            return &_paged[i];
+        }
+    }
+#else
+    (void)key;
+#endif
+    return NULL;
+}
+//------------------------------------------------------------------------------
+/*
+ * -- holdEntry(uint32_t, nextionComponent*, const char*, bool): the entry where a write must be kept
+ * instead of sent, or NULL if it can be sent now. While Nextion sleeps, every write gets an entry of
+ * its own (page NEX_PAGE_ANY) until it wakes up. A handle is kept by its address (name is NULL), a plain
+ * name is copied, as the text of the caller may be gone by then. Without room, NULL is returned.
+ */
+nextion_ez::pagedEntry* nextion_ez::holdEntry(uint32_t key, const nextionComponent* comp, const char* name, bool nameInFlash){
+#if NEXTION_EZ_PAGED > 0
+    pagedEntry* entry = (_pagedCount > 0) ? findPaged(key) : NULL;
+    if(entry == NULL && _asleep && _pagedCount < NEXTION_EZ_PAGED){
+        if(comp != NULL){
+            entry = &_paged[_pagedCount++];
+            entry->comp = comp;
+        }
+#if NEXTION_EZ_SLEEP_NAME > 0
+        else if(name != NULL){
+            size_t length = nameInFlash ? strlen_P(name) : strlen(name);
+            if(length <= NEXTION_EZ_SLEEP_NAME){
+                entry = &_paged[_pagedCount++];
+                entry->comp = NULL;
+                if(nameInFlash){
+                    memcpy_P(entry->name, name, length + 1);
+                }else{
+                    memcpy(entry->name, name, length + 1);
+                }
+            }
+        }
+#else
+        (void)name;
+        (void)nameInFlash;
+#endif
+        if(entry != NULL){
+            entry->key = key;
+            entry->page = NEX_PAGE_ANY;
+            entry->state = NEX_PAGED_NONE;
+        }
+    }
+    if(entry == NULL){
+        return NULL;
+    }
+    if(!_asleep && (entry->page == NEX_PAGE_ANY || entry->page == _currentPageId)){
+        entry->state = NEX_PAGED_NONE;  // sent now, an older kept value is not needed
+        return NULL;
+    }
+    return entry;
+#else
+    (void)key;
+    (void)comp;
+    (void)name;
+    (void)nameInFlash;
+    return NULL;                        // nothing can be kept, a write while Nextion sleeps is lost
+#endif
+}
+//------------------------------------------------------------------------------
+/*
+ * -- deferNum(), deferStr(): true if the write must not be sent now, because the page of the component
+ * is not shown or Nextion sleeps. The value is kept for sendPaged() when possible, a newer value takes
+ * the place of the older one. While Nextion sleeps, nothing is sent, and what cannot be kept is
+ * counted by lostWrites().
+ */
+bool nextion_ez::deferNum(uint32_t key, const nextionComponent* comp, const char* name, bool nameInFlash, uint32_t value, uint8_t state){
+    if(_pagedCount == 0 && !_asleep){
+        return false;
+    }
+    pagedEntry* entry = holdEntry(key, comp, name, nameInFlash);
+    if(entry == NULL){
+        return lostWrite(key);
+    }
+    entry->state = state;               // NEX_PAGED_INT for writeInt(), to send it again with its sign
+    entry->value = value;
+    cacheForget(key);                   // Nextion shows an other value until sendPaged()
+    return true;
+}
+
+bool nextion_ez::deferStr(uint32_t key, const nextionComponent* comp, const char* name, bool nameInFlash,
+                          const char* txt, size_t length, bool inFlash){
+    if(_pagedCount == 0 && !_asleep){
+        return false;
+    }
+    if(length > NEXTION_EZ_PAGED_TEXT){ // too long to keep, it must not take an entry
+        pagedEntry* entry = findPaged(key);
+        if(entry != NULL){
+            entry->state = NEX_PAGED_NONE;  // an older kept text would come after this one
+        }
+        return lostWrite(key);
+    }
+    pagedEntry* entry = holdEntry(key, comp, name, nameInFlash);
+    if(entry == NULL){
+        return lostWrite(key);
+    }
+#if NEXTION_EZ_PAGED_TEXT > 0
+    if(inFlash){
+        memcpy_P(entry->text, txt, length);
+    }else{
+        memcpy(entry->text, txt, length);
+    }
+    entry->text[length] = '\0';
+    entry->state = NEX_PAGED_TEXT;
+    cacheForget(key);
+    return true;
+#else
+    (void)txt;
+    (void)inFlash;
+    entry->state = NEX_PAGED_NONE;      // texts are not kept
+    return lostWrite(key);
+#endif
+}
+
+bool nextion_ez::lostWrite(uint32_t key){  // a write that could not be kept: true while Nextion sleeps, it is lost then
+    if(!_asleep){
+        return false;
+    }
+    _lostWrites++;
+    cacheForget(key);
+    return true;
+}
+//------------------------------------------------------------------------------
+/*
+ * -- sendPaged(): called when a page is loaded, sends the kept values of its components in one batch
+ */
+void nextion_ez::sendPaged(){
+#if NEXTION_EZ_PAGED > 0
+    if(_asleep){
+        return;
+    }
+    bool hold = _txHold;
+    _txHold = true;                     // all in one write(), like beginBatch()
+    for(uint8_t i = 0; i < _pagedCount; i++){
+        pagedEntry* entry = &_paged[i];
+        if(entry->state == NEX_PAGED_NONE || (entry->page != NEX_PAGE_ANY && entry->page != _currentPageId)){
+            continue;
+        }
+        if(entry->comp == NULL){
+            sendPagedName(entry);       // a plain name kept while Nextion slept
+        }
+        else if(entry->state == NEX_PAGED_NUM){
+            writeNum(*entry->comp, entry->value);  // the page is shown now, so it is sent
+        }
+        else if(entry->state == NEX_PAGED_INT){
+            writeInt(*entry->comp, (int32_t)entry->value);
+        }
+#if NEXTION_EZ_PAGED_TEXT > 0
+        else{
+            writeStr(*entry->comp, entry->text);
+        }
+#endif
+    }
+    _txHold = hold;
+    if(!hold){
+        txSend();
+    }
+
+    uint8_t count = 0;                  // the entries made only for the sleep are not needed any more
+    for(uint8_t i = 0; i < _pagedCount; i++){
+        if(_paged[i].page != NEX_PAGE_ANY){
+            _paged[count++] = _paged[i];
+        }
+    }
+    _pagedCount = count;
+#endif
+}
+//------------------------------------------------------------------------------
+/*
+ * -- sendPagedName(pagedEntry*): sends the kept value of a plain name, with the name copied by holdEntry()
+ */
+void nextion_ez::sendPagedName(pagedEntry* entry){
+#if NEXTION_EZ_SLEEP_NAME > 0
+    if(entry->state == NEX_PAGED_NUM){
+        writeNum(entry->name, entry->value);
+    }
+    else if(entry->state == NEX_PAGED_INT){
+        writeInt(entry->name, (int32_t)entry->value);
+    }
+#if NEXTION_EZ_PAGED_TEXT > 0
+    else{
+        writeStr(entry->name, entry->text);
+    }
+#endif
+#else
+    (void)entry;
+#endif
+}
+//------------------------------------------------------------------------------
+/*
+ * -- isAsleep(): true from the 0x86 (entered sleep) of Nextion up to the 0x87 (woke up) or 0x88 (ready)
+ * While Nextion sleeps, writeNum() and writeStr() send nothing. The newest value of each component is
+ * kept (up to NEXTION_EZ_PAGED, with the onPage() ones) and sent when Nextion wakes up. Plain names are
+ * copied, up to NEXTION_EZ_SLEEP_NAME characters. Writes that cannot be kept (table full, longer names,
+ * texts longer than NEXTION_EZ_PAGED_TEXT) are counted by lostWrites(). With NEXTION_EZ_PAGED 0 all of them are.
+ * Syntax: | if(!myObject.isAsleep()){ readSensors(); } |
+ */
+bool nextion_ez::isAsleep(){
+    NEX_GUARD();
+    return _asleep;
+}
+//------------------------------------------------------------------------------
+/*
+ * -- lostWrites(): how many writes were not sent and not kept while Nextion slept, since begin()
+ * Syntax: | if(myObject.lostWrites() > 0){ myObject.sendCmd("page 0"); } |
+ */
+uint16_t nextion_ez::lostWrites(){
+    NEX_GUARD();
+    return _lostWrites;
+}
+//------------------------------------------------------------------------------
+/*
+ * -- setSleepCallback(nextionSleepCallback): a function of yours that listen() calls when Nextion
+ * goes to sleep (true) or wakes up (false). NULL stops it.
+ * nextionSleepCallback = void name(bool asleep)
+ * Syntax: | myObject.setSleepCallback(sleepChanged); |
+ */
+void nextion_ez::setSleepCallback(nextionSleepCallback callback){
+    NEX_GUARD();
+    _sleepCallback = callback;
+}
+//------------------------------------------------------------------------------
+/*
+ * -- setAsleep(bool): called by readReply() for 0x86, 0x87 and 0x88
+ */
+void nextion_ez::setAsleep(bool asleep){
+    bool changed = (asleep != _asleep);
+    _asleep = asleep;
+    if(!asleep){
+        sendPaged();                    // the newest values kept during the sleep
+    }
+    if(changed && _sleepCallback != NULL){
+        _sleepCallback(asleep);
+    }
+}
+//------------------------------------------------------------------------------
+/*
+ * -- cacheSame(uint32_t, uint32_t): true if this value was the last one written to the component,
+ * sent or still on its way. Otherwise false is returned, so the write goes on, and txEnd()
+ * remembers the new value once the command is built.
+ * Components and texts are kept as 32 bit hashes, not as text, to save RAM.
+ */
+bool nextion_ez::cacheSame(uint32_t key, uint32_t value){
+    _txKey = key;                       // txEnd() also drops older values of this component from the bulk queue
+    if(!_cacheOn){
+        return false;
+    }
+
+#if NEXTION_EZ_CACHE > 0
+    for(uint8_t i = 0; i < NEXTION_EZ_CACHE; i++){
+        if(_cache[i].state != NEX_CACHE_FREE && _cache[i].key == key && _cache[i].value == value){
+            _txKey = 0;
+            return true;
+        }
+    }
+#endif
+    _txCached = true;
+    _txValue = value;
+    return false;
+}
+//------------------------------------------------------------------------------
+/*
+ * -- cacheKeep(uint32_t, uint8_t): the write of _txValue is built, it waits in _txBuf (NEX_CACHE_HELD)
+ * or in the bulk queue (NEX_CACHE_BULK). It counts as sent only when its bytes go to the Serial.
+ */
+void nextion_ez::cacheKeep(uint32_t key, uint8_t state){
+#if NEXTION_EZ_CACHE > 0
+    cacheEntry* entry = NULL;
+    for(uint8_t i = 0; i < NEXTION_EZ_CACHE; i++){
+        if(_cache[i].state != NEX_CACHE_FREE && _cache[i].key == key){
+            entry = &_cache[i];
+            break;
+        }
+    }
+    if(entry == NULL){
+        entry = &_cache[_cacheNext];    // a new component, it takes the place of the oldest one
+        _cacheNext++;
+        if(_cacheNext >= NEXTION_EZ_CACHE) _cacheNext = 0;
+    }
+    entry->key = key;
+    entry->value = _txValue;
+    entry->state = state;
+    if(state == NEX_CACHE_HELD){
+        _cacheHeld = true;
+    }
+#else
+    (void)key;
+    (void)state;
+#endif
+}
+//------------------------------------------------------------------------------
+/*
+ * -- cacheSent(uint8_t, uint32_t): the entries in this state have gone to the Serial,
+ * all of them or only the one of key (not 0)
+ */
+void nextion_ez::cacheSent(uint8_t state, uint32_t key){
+#if NEXTION_EZ_CACHE > 0
+    for(uint8_t i = 0; i < NEXTION_EZ_CACHE; i++){
+        if(_cache[i].state == state && (key == 0 || _cache[i].key == key)){
+            _cache[i].state = NEX_CACHE_SENT;
+        }
+    }
+#else
+    (void)state;
+    (void)key;
+#endif
+}
+//------------------------------------------------------------------------------
+/*
+ * -- cacheForget(uint32_t): the value of this component on Nextion is not sure any more,
+ * its next write is sent
+ */
+void nextion_ez::cacheForget(uint32_t key){
+#if NEXTION_EZ_CACHE > 0
+    for(uint8_t i = 0; i < NEXTION_EZ_CACHE; i++){
+        if(_cache[i].state != NEX_CACHE_FREE && _cache[i].key == key){
+            _cache[i].state = NEX_CACHE_FREE;
+        }
+    }
+#else
+    (void)key;
+#endif
+}
+//------------------------------------------------------------------------------
+/*
+ * -- hashText(): FNV-1a hash of a text, used by the cache
+ */
+uint32_t nextion_ez::hashText(const char* txt){
+    uint32_t hash = 2166136261UL;
+    while(*txt != '\0'){
+        hash ^= (uint8_t)*txt++;
+        hash *= 16777619UL;
+    }
+    return hash;
+}
+
+uint32_t nextion_ez::hashText(const char* txt, size_t length){
+    uint32_t hash = 2166136261UL;
+    while(length > 0){
+        hash ^= (uint8_t)*txt++;
+        hash *= 16777619UL;
+        length--;
+    }
+    return hash;
+}
+
+uint32_t nextion_ez::hashText(const __FlashStringHelper* txt){
+    const char* p = reinterpret_cast<const char*>(txt);
+    uint32_t hash = 2166136261UL;
+    char c = pgm_read_byte(p++);
+    while(c != '\0'){
+        hash ^= (uint8_t)c;
+        hash *= 16777619UL;
+        c = pgm_read_byte(p++);
+    }
+    return hash;
+}
+#if NEXTION_EZ_STATS
+//------------------------------------------------------------------------------
+/*
+ * -- getStats(): the counters of the link since begin() or resetStats(). Only with NEXTION_EZ_STATS 1
+ * Syntax: | const nextionStats& stats = myObject.getStats(); Serial.println(stats.requestTimeouts); |
+ */
+const nextionStats& nextion_ez::getStats(){
+    NEX_GUARD();
+    return _stats;
+}
+//------------------------------------------------------------------------------
+/*
+ * -- resetStats(): all the counters back to 0
+ * Syntax: | myObject.resetStats(); |
+ */
+void nextion_ez::resetStats(){
+    NEX_GUARD();
+    memset(&_stats, 0, sizeof(_stats));
+    _statsTime = millis();
+}
+//------------------------------------------------------------------------------
+/*
+ * -- setStatsReport(nextionStatsCallback, unsigned long): listen() calls a function of yours every
+ * interval milliseconds with the counters, to print or log them. NULL stops it.
+ * nextionStatsCallback = void name(const nextionStats& stats)
+ * Syntax: | myObject.setStatsReport(printStats, 10000); |
+ */
+void nextion_ez::setStatsReport(nextionStatsCallback callback, unsigned long interval){
+    NEX_GUARD();
+    _statsCallback = callback;
+    _statsInterval = interval;
+    _statsTime = millis();
+}
+//------------------------------------------------------------------------------
+/*
+ * -- countFrame(): adds the frame that just arrived to its counter
+ */
+void nextion_ez::countFrame(){
+    switch(_frameCode){
+      case 0x71: _stats.numReplies++; break;
+      case 0x70: _stats.strReplies++; break;
+      case 0x01: _stats.okFrames++; break;
+      case 0x66: _stats.pageFrames++; break;
+      case 0x65: case 0x67: case 0x68: _stats.touchFrames++; break;
+      case 0x86: case 0x87: case 0x88: case 0x89: case 0xFD: case 0xFE: _stats.otherFrames++; break;
+      default: _stats.errorFrames++; break;
+    }
+}
+#endif
+#if NEXTION_EZ_TRACE
+//------------------------------------------------------------------------------
+/*
+ * -- traceTo(uint8_t*, uint16_t): records every byte sent and received in a char array of yours,
+ * as records of <sent|length> <ms low> <ms high> <bytes>, ms since the record before.
+ * When the array is full the oldest records are dropped, so it always keeps the last moments before a problem.
+ * Only with NEXTION_EZ_TRACE 1. traceDump() writes them out, nextionReplay plays them again.
+ * Syntax: | uint8_t trace[2048]; myObject.traceTo(trace, sizeof(trace)); |
+ */
+void nextion_ez::traceTo(uint8_t* buffer, uint16_t size){
+    NEX_GUARD();
+    traceEnd();
+    _traceOut = NULL;
+    _traceRing = buffer;
+    _traceSize = size;
+    _traceTail = 0;
+    _traceUsed = 0;
+    _traceTime = millis();
+    _traceOn = true;
+}
+//------------------------------------------------------------------------------
+/*
+ * -- traceTo(Stream&): the same records, written to a Stream as they are made: an SD card File, a second Serial...
+ * Writing takes time, so a slow Stream also slows the library while it records.
+ * Syntax: | File log = SD.open("nextion.bin", FILE_WRITE); myObject.traceTo(log); |
+ */
+void nextion_ez::traceTo(Stream& out){
+    NEX_GUARD();
+    traceEnd();
+    _traceOut = &out;
+    _traceRing = NULL;
+    _traceUsed = 0;
+    _traceTime = millis();
+    _traceOn = true;
+}
+//------------------------------------------------------------------------------
+/*
+ * -- traceStop(): ends the recording. The records of the char array stay there for traceDump()
+ * Syntax: | myObject.traceStop(); |
+ */
+void nextion_ez::traceStop(){
+    NEX_GUARD();
+    traceEnd();
+    _traceOn = false;
+}
+//------------------------------------------------------------------------------
+/*
+ * -- traceDump(Stream&): writes the records of traceTo(buffer, size), oldest first, to a Stream.
+ * The array is not emptied, the recording goes on if it was not stopped.
+ * Syntax: | myObject.traceDump(Serial); |
+ */
+void nextion_ez::traceDump(Stream& out){
+    NEX_GUARD();
+    traceEnd();
+    if(_traceRing == NULL){
+        return;
+    }
+    uint16_t first = _traceSize - _traceTail;   // the part up to the end of the array
+    if(first > _traceUsed) first = _traceUsed;
+    out.write(&_traceRing[_traceTail], first);
+    if(_traceUsed > first){
+        out.write(&_traceRing[0], _traceUsed - first);
+    }
+}
+//------------------------------------------------------------------------------
+/*
+ * -- traceByte(bool, uint8_t): adds a byte to the record being filled. A new record starts when
+ * the direction changes or the record is full. traceEnd() closes the record, tracePut() stores it.
+ */
+void nextion_ez::traceByte(bool sent, uint8_t c){
+    if(!_traceOn){
+        return;
+    }
+    uint8_t kind = sent ? NEX_TRACE_SENT : 0;
+    if(_traceLen > 0 && ((_traceRec[0] & NEX_TRACE_SENT) != kind || _traceLen >= NEX_TRACE_CHUNK)){
+        traceEnd();
+    }
+    if(_traceLen == 0){
+        unsigned long now = millis();
+        unsigned long time = now - _traceTime;
+        _traceTime = now;
+        while(time > 0xFFFF){           // a long pause: empty records that only carry the time
+            const uint8_t pause[NEX_TRACE_HEADER] = {0, 0xFF, 0xFF};
+            tracePut(pause, NEX_TRACE_HEADER);
+            time -= 0xFFFF;
+        }
+        _traceRec[1] = (uint8_t)time;
+        _traceRec[2] = (uint8_t)(time >> 8);
+    }
+    _traceRec[NEX_TRACE_HEADER + _traceLen++] = c;
+    _traceRec[0] = kind | _traceLen;
+}
+
+void nextion_ez::traceEnd(){
+    if(_traceLen > 0){
+        tracePut(_traceRec, NEX_TRACE_HEADER + _traceLen);
+        _traceLen = 0;
+    }
+}
+
+void nextion_ez::tracePut(const uint8_t* data, uint16_t length){
+    if(_traceOut != NULL){
+        _traceOut->write(data, length);
+        return;
+    }
+    if(_traceRing == NULL || length > _traceSize){
+        return;
+    }
+    while(_traceSize - _traceUsed < length){    // drop the oldest records until it fits
+        uint16_t drop = NEX_TRACE_HEADER + (_traceRing[_traceTail] & NEX_TRACE_LENGTH);
+        _traceTail += drop;
+        if(_traceTail >= _traceSize) _traceTail -= _traceSize;
+        _traceUsed -= drop;
+    }
+    uint16_t place = _traceTail + _traceUsed;
+    if(place >= _traceSize) place -= _traceSize;
+    for(uint16_t i = 0; i < length; i++){
+        _traceRing[place++] = data[i];
+        if(place >= _traceSize) place = 0;
+    }
+    _traceUsed += length;
+}
+#endif
+//------------------------------------------------------------------------------
+/*
+ * -- beginBatch(): the commands that follow are kept in the transmit buffer of the library
+ * and are sent all together by flush(). This saves time when many values are updated at once.
+ * If the buffer gets full, its content is sent and the batch goes on.
+ * Syntax: | myObject.beginBatch(); myObject.writeNum("n0.val", 1); myObject.writeNum("n1.val", 2); myObject.flush(); |
+ */
+void nextion_ez::beginBatch(){
+    NEX_GUARD();
+    _txHold = true;
+}
+//------------------------------------------------------------------------------
+/*
+ * -- flush(): sends everything waiting in the transmit buffer and ends a batch started by beginBatch()
+ * readNum() and readStr() send the buffer too, but the batch goes on until flush()
+ */
+void nextion_ez::flush(){
+    NEX_GUARD();
+    _txHold = false;
+    txSend();
+}
+//------------------------------------------------------------------------------
+/*
+ * -- setPriority(uint8_t): NEX_PRIO_HIGH (the default) sends the commands that follow at once.
+ * With NEX_PRIO_BULK they wait in a queue of NEXTION_EZ_BULK_SIZE bytes and listen() sends them only when
+ * the transmit buffer of the Serial has room for a whole command, so it never blocks and the
+ * NEX_PRIO_HIGH commands, like the answer to a button, do not wait behind them.
+ * When a component is written again, an older value still in the queue is not sent, only the newest.
+ * A write never waits for the queue: when it is full, the command is sent at once, as NEX_PRIO_HIGH.
+ * With NEXTION_EZ_BULK_SIZE 0 there is no queue, every command is sent at once.
+ * Syntax: | myObject.setPriority(NEX_PRIO_BULK); myObject.writeStr("t0.txt", longText); myObject.setPriority(NEX_PRIO_HIGH); |
+ */
+void nextion_ez::setPriority(uint8_t priority){
+    NEX_GUARD();
+    _txPriority = priority;
+}
+//------------------------------------------------------------------------------
+/*
+ * -- pendingBulk(): the bytes waiting in the bulk queue
+ * Syntax: | if(myObject.pendingBulk() == 0){ ... } |
+ */
+int nextion_ez::pendingBulk(){
+    NEX_GUARD();
+    return _bulkUsed;
+}
+//------------------------------------------------------------------------------
+/*
+ * -- bulkAdd(uint8_t, uint32_t): moves the command just built from the transmit buffer to the bulk queue.
+ * It never waits: false if the queue has no room, even without the commands that are not sent any more,
+ * then it is sent as a NEX_PRIO_HIGH one.
+ */
+bool nextion_ez::bulkAdd(uint8_t ack, uint32_t key){
+#if NEXTION_EZ_BULK_SIZE > 0
+    uint16_t length = _txCmdBytes;
+    if(length > 255 || length + NEX_BULK_HEADER > NEXTION_EZ_BULK_SIZE){
+        return false;
+    }
+    if(_bulkUsed + NEX_BULK_HEADER + length > NEXTION_EZ_BULK_SIZE){
+        bulkCompact();                  // the room of the older values of bulkForget()
+        if(_bulkUsed + NEX_BULK_HEADER + length > NEXTION_EZ_BULK_SIZE){
+            NEX_STAT(_stats.bulkFull++);
+            return false;
+        }
+    }
+
+    const uint8_t* command = &_txBuf[_txLen - length];
+    uint8_t header[NEX_BULK_HEADER] = {ack, (uint8_t)length, (uint8_t)key, (uint8_t)(key >> 8),
+                                       (uint8_t)(key >> 16), (uint8_t)(key >> 24)};
+    uint16_t place = _bulkTail + _bulkUsed;
+    for(uint16_t i = 0; i < NEX_BULK_HEADER + length; i++){
+        if(place >= NEXTION_EZ_BULK_SIZE) place -= NEXTION_EZ_BULK_SIZE;
+        _bulk[place++] = (i < NEX_BULK_HEADER) ? header[i] : command[i - NEX_BULK_HEADER];
+    }
+    _bulkUsed += NEX_BULK_HEADER + length;
+    _txLen -= length;
+    return true;
+#else
+    (void)ack;
+    (void)key;
+    return false;                       // no queue, the command is sent at once
+#endif
+}
+//------------------------------------------------------------------------------
+/*
+ * -- bulkCompact(): removes the entries marked by bulkForget(), the others keep their order
+ */
+void nextion_ez::bulkCompact(){
+#if NEXTION_EZ_BULK_SIZE > 0
+    uint16_t offset = 0;
+    uint16_t kept = 0;
+    while(offset < _bulkUsed){
+        uint16_t size = NEX_BULK_HEADER + bulkByte(offset + 1);
+        if(bulkByte(offset) != NEX_BULK_DEAD){
+            for(uint16_t i = 0; i < size; i++){
+                uint16_t place = _bulkTail + kept + i;
+                if(place >= NEXTION_EZ_BULK_SIZE) place -= NEXTION_EZ_BULK_SIZE;
+                _bulk[place] = bulkByte(offset + i);  // kept is never after offset, so nothing is lost
+            }
+            kept += size;
+        }
+        offset += size;
+    }
+    _bulkUsed = kept;
+#endif
+}
+//------------------------------------------------------------------------------
+/*
+ * -- bulkForget(uint32_t): marks the queued commands of this component, so they are not sent
+ */
+void nextion_ez::bulkForget(uint32_t key){
+#if NEXTION_EZ_BULK_SIZE > 0
+    uint16_t offset = 0;
+    while(offset < _bulkUsed){
+        if(bulkKey(offset) == key){
+            uint16_t place = _bulkTail + offset;
+            if(place >= NEXTION_EZ_BULK_SIZE) place -= NEXTION_EZ_BULK_SIZE;
+            _bulk[place] = NEX_BULK_DEAD;
+        }
+        offset += NEX_BULK_HEADER + bulkByte(offset + 1);
+    }
+#else
+    (void)key;
+#endif
+}
+
+uint32_t nextion_ez::bulkKey(uint16_t offset){  // the key of the command at offset, 0 if it is not a write
+    return (uint32_t)bulkByte(offset + 2) | ((uint32_t)bulkByte(offset + 3) << 8) |
+           ((uint32_t)bulkByte(offset + 4) << 16) | ((uint32_t)bulkByte(offset + 5) << 24);
+}
+
+uint8_t nextion_ez::bulkByte(uint16_t offset){  // a byte of the queue, counted from its oldest one
+#if NEXTION_EZ_BULK_SIZE > 0
+    uint16_t place = _bulkTail + offset;
+    if(place >= NEXTION_EZ_BULK_SIZE) place -= NEXTION_EZ_BULK_SIZE;
+    return _bulk[place];
+#else
+    (void)offset;
+    return 0;
+#endif
+}
+//------------------------------------------------------------------------------
+/*
+ * -- sendBulk(): called by listen(), sends the commands of the bulk queue that fit
+ * in the transmit buffer of the Serial right now
+ */
+void nextion_ez::sendBulk(){
+#if NEXTION_EZ_BULK_SIZE > 0
+    while(_bulkUsed > 0){
+        uint8_t ack = bulkByte(0);
+        uint8_t length = bulkByte(1);
+
+        if(ack != NEX_BULK_DEAD){
+            if(_waveState == NEX_WAVE_READY || _flowWaiting){
+                return;                 // Nextion waits for waveform data, or a NEX_PRIO_HIGH command waits
+            }
+            if(_flowOn && ack != NEX_ACK_NONE && flowFull(length)){
+                return;                 // the window of useFlowControl() is full
+            }
+            int room = _serial->availableForWrite();
+            if(room > _txRoomMax) _txRoomMax = room;
+            if(room < length && room < _txRoomMax){
+                return;                 // wait for room, unless the buffer is empty (or its size is unknown)
+            }
+
+            uint16_t place = _bulkTail + NEX_BULK_HEADER;
+            if(place >= NEXTION_EZ_BULK_SIZE) place -= NEXTION_EZ_BULK_SIZE;
+            uint16_t first = NEXTION_EZ_BULK_SIZE - place;  // the part up to the end of the ring
+            if(first > length) first = length;
+            txWrite(&_bulk[place], first);
+            if(length > first){
+                txWrite(&_bulk[0], length - first);
+            }
+            NEX_STAT(_stats.txBytes += length);
+            _writeCount++;
+            uint32_t key = bulkKey(0);
+            if(_flowOn && ack != NEX_ACK_NONE){
+                flowAdd(length, ack == NEX_ACK_GET, key);
+            }
+            if(key != 0 && _cacheOn){
+                cacheSent(NEX_CACHE_BULK, key);
+            }
+        }
+
+        _bulkTail += NEX_BULK_HEADER + length;
+        if(_bulkTail >= NEXTION_EZ_BULK_SIZE) _bulkTail -= NEXTION_EZ_BULK_SIZE;
+        _bulkUsed -= NEX_BULK_HEADER + length;
+    }
+#endif
+}
+//------------------------------------------------------------------------------
+/*
+ * -- useFlowControl(bool): with true, Nextion is set to answer every command (bkcmd=3) and the library
+ * keeps count of the commands that are not answered yet. When NEXTION_EZ_WINDOW commands, or 512 bytes,
+ * are waiting, the next write waits (calling listen()) until Nextion catches up. This way the
+ * 1024 byte Serial buffer of Nextion never overflows (error 0x24) and no command is lost.
+ * With false, Nextion is set back to answer only the errors (bkcmd=2). With NEXTION_EZ_WINDOW 0 it does nothing.
+ * Syntax: | myObject.useFlowControl(true); |
+ */
+void nextion_ez::useFlowControl(bool on){
+    NEX_GUARD();
+#if NEXTION_EZ_WINDOW > 0
+    if(on == _flowOn){
+        return;
+    }
+    _flowHead = 0;
+    _flowTail = 0;
+    _flowCount = 0;
+    _flowBytes = 0;
+    _flowUnsent = 0;
+
+    if(on){
+        _flowOn = true;                 // the answer of bkcmd=3 is already counted
+        sendCmd(F("bkcmd=3"));
+    }else{
+        _flowOn = false;
+        sendCmd(F("bkcmd=2"));
+    }
+#else
+    (void)on;                           // no window to count the commands, flow control stays off
+#endif
+}
+//------------------------------------------------------------------------------
+/*
+ * -- setFlowWindow(uint8_t, uint16_t): how many commands and how many bytes can wait for an answer
+ * The commands are limited by NEXTION_EZ_WINDOW. Keep the bytes well under 1024, the Nextion buffer.
+ * Syntax: | myObject.setFlowWindow(4, 256); |
+ */
+void nextion_ez::setFlowWindow(uint8_t commands, uint16_t bytes){
+    NEX_GUARD();
+    if(commands < 1) commands = 1;
+    if(commands > NEXTION_EZ_WINDOW) commands = NEXTION_EZ_WINDOW;
+    _flowMaxCmds = commands;
+    _flowMaxBytes = bytes;
+}
+//------------------------------------------------------------------------------
+/*
+ * -- setCommandCallback(nextionCmdCallback): a function of yours, void name(uint16_t id, uint8_t status),
+ * that is called for every answered command when useFlowControl(true) is on.
+ * id is the number lastCommandId() gave after the write, status is NEX_OK, NEX_ERROR
+ * (getLastError() has the error code) or NEX_TIMEOUT.
+ * Syntax: | myObject.setCommandCallback(commandDone); |
+ */
+void nextion_ez::setCommandCallback(nextionCmdCallback callback){
+    NEX_GUARD();
+    _cmdCallback = callback;
+}
+//------------------------------------------------------------------------------
+uint16_t nextion_ez::lastCommandId(){   //returns the id of the last command sent, for setCommandCallback()
+    NEX_GUARD();
+    return _cmdId;
+}
+//------------------------------------------------------------------------------
+int nextion_ez::pendingCommands(){      //returns the number of commands waiting for an answer
+    NEX_GUARD();
+    return _flowCount;
+}
+//------------------------------------------------------------------------------
+/*
+ * -- flowFull(uint16_t): true if a command of this size must wait for answers before it is sent.
+ * A single command always goes, even if it is longer than the window.
+ */
+bool nextion_ez::flowFull(uint16_t bytes){
+    return _flowCount > 0 && (_flowCount >= _flowMaxCmds || _flowBytes + bytes > _flowMaxBytes);
+}
+//------------------------------------------------------------------------------
+/*
+ * -- flowWait(): called by txEnd() when the window is full. The command being built is taken out of
+ * _txBuf, listen() reads the answers of the older commands until there is room, and then the command
+ * is put back, to be sent. A callback that writes while we wait waits too, and its command goes first.
+ * The commands kept by beginBatch() are sent only when no sent command is left to answer,
+ * otherwise their answers would never come.
+ */
+void nextion_ez::flowWait(){
+    uint16_t bytes = _txCmdBytes;
+    uint8_t held = (_txCmdBytes < _txLen) ? _txCmdBytes : _txLen;  // the rest of a long command is already sent
+    uint8_t command[NEXTION_EZ_TX_SIZE];
+    _txLen -= held;
+    memcpy(command, &_txBuf[_txLen], held);
+    _txCmdBytes = 0;                    // the commands of callbacks count their own bytes
+
+    bool waiting = _flowWaiting;
+    _flowWaiting = true;                // the bulk queue waits too
+    while(_flowOn && flowFull(bytes)){
+        if(_flowUnsent >= _flowCount){
+            txSend();                   // only sent commands can be answered
+        }
+        listen();
+    }
+    _flowWaiting = waiting;
+
+    for(uint8_t i = 0; i < held; i++){
+        txChar(command[i]);
+    }
+    _txCmdBytes = bytes;
+}
+//------------------------------------------------------------------------------
+/*
+ * -- flowAdd(uint16_t, bool, uint32_t): counts a new command, it waits for its answer from now on
+ */
+void nextion_ez::flowAdd(uint16_t bytes, bool isGet, uint32_t key){
+    _cmdId++;
+#if NEXTION_EZ_WINDOW > 0
+    if(_flowCount >= NEXTION_EZ_WINDOW){
+        flowDone(NEX_TIMEOUT);          // no room to keep it, forget the oldest
+    }
+
+    flowEntry* entry = &_flow[_flowHead];
+    entry->id = _cmdId;
+    entry->bytes = bytes;
+    entry->isGet = isGet;
+    entry->sent = millis();
+    entry->key = key;
+    _flowHead++;
+    if(_flowHead >= NEXTION_EZ_WINDOW) _flowHead = 0;
+    _flowCount++;
+    _flowBytes += bytes;
+#else
+    (void)bytes;
+    (void)isGet;
+    (void)key;
+#endif
+}
+//------------------------------------------------------------------------------
+/*
+ * -- flowDone(uint8_t): Nextion answered the oldest command (0x01, an error code or the data of a get)
+ */
+void nextion_ez::flowDone(uint8_t status){
+#if NEXTION_EZ_WINDOW > 0
+    if(_flowCount == 0){
+        return;                         // an answer we did not count, like that of bkcmd itself
+    }
+
+    flowEntry entry = _flow[_flowTail];
+    _flowTail++;
+    if(_flowTail >= NEXTION_EZ_WINDOW) _flowTail = 0;
+    _flowCount--;
+    _flowBytes -= entry.bytes;
+
+    if(entry.isGet && status == NEX_ERROR){
+        finishRequest(NEX_ERROR);       // the get failed, its request gets no data
+    }
+    if(status != NEX_OK && entry.key != 0){
+        cacheForget(entry.key);         // the write failed or got lost, Nextion may show an other value
+    }
+    if(_cmdCallback != NULL){
+        _cmdCallback(entry.id, status);
+    }
+#else
+    (void)status;
+#endif
+}
+//------------------------------------------------------------------------------
+/*
+ * The tx...() functions build each command in _txBuf, so that the whole command
+ * goes to the Serial with one write() instead of many print() calls.
+ */
+void nextion_ez::txSend(){
+    if(_waveState == NEX_WAVE_READY){   // Nextion takes the next bytes as waveform data,
+        if(_txLen < NEXTION_EZ_TX_SIZE){  // so the commands wait in the buffer until the data is sent
+            return;
+        }
+        bool waiting = _txWaiting;
+        _txWaiting = true;              // listen() must not start an other block meanwhile
+        while(_waveState == NEX_WAVE_READY){  // the buffer is full, we have to wait for it
+            listen();                   // 0xFE, an error or the timeout of addt ends it
+        }
+        _txWaiting = waiting;
+    }
+    if(_txLen > 0){
+        txWrite(_txBuf, _txLen);
+        NEX_STAT(_stats.txBytes += _txLen);
+        _txLen = 0;
+        _flowUnsent = 0;                // every counted command is on its way
+        if(_cacheHeld){
+            _cacheHeld = false;
+            cacheSent(NEX_CACHE_HELD, 0);  // their values are on Nextion now
+        }
+    }
+}
+
+void nextion_ez::txWrite(const uint8_t* data, size_t length){  // every byte to the Serial goes here
+    _serial->write(data, length);
+#if NEXTION_EZ_TRACE
+    for(size_t i = 0; i < length; i++){
+        traceByte(true, data[i]);
+    }
+    traceEnd();
+#endif
+}
+
+void nextion_ez::txChar(uint8_t c){
+    if(_txLen >= NEXTION_EZ_TX_SIZE){
+        txSend();                       // the buffer is full, send what we have so far
+    }
+    _txBuf[_txLen++] = c;
+    _txCmdBytes++;
+}
+
+void nextion_ez::txText(const char* txt){
+    while(*txt != '\0'){
+        txChar(*txt++);
+    }
+}
+
+void nextion_ez::txText(const char* txt, size_t length){
+    while(length > 0){
+        if(_txLen >= NEXTION_EZ_TX_SIZE){
+            txSend();
+        }
+        size_t part = NEXTION_EZ_TX_SIZE - _txLen;
+        if(part > length) part = length;
+        memcpy(&_txBuf[_txLen], txt, part);
+        _txLen += part;
+        _txCmdBytes += part;
+        txt += part;
+        length -= part;
+    }
+}
+
+void nextion_ez::txText(const __FlashStringHelper* txt){  // text stored in flash with F()
+    const char* p = reinterpret_cast<const char*>(txt);
+    char c = pgm_read_byte(p++);
+    while(c != '\0'){
+        txChar(c);
+        c = pgm_read_byte(p++);
+    }
+}
+
+void nextion_ez::txFlash(const char* txt, uint8_t length){  // text in flash with a known length
+    while(length > 0){
+        if(_txLen >= NEXTION_EZ_TX_SIZE){
+            txSend();
+        }
+        uint8_t part = NEXTION_EZ_TX_SIZE - _txLen;
+        if(part > length) part = length;
+        memcpy_P(&_txBuf[_txLen], txt, part);
+        _txLen += part;
+        _txCmdBytes += part;
+        txt += part;
+        length -= part;
+    }
+}
+
+/*
+ * txNumber() finds each digit by subtracting its power of ten, at most 9 times, instead of dividing.
+ * An 8 bit board has no divide instruction and a 32 bit division costs hundreds of cycles.
+ * Other boards (and the PC) divide by the constant 10 with a multiply, which is faster than the
+ * subtractions there, as bench_commands of extras/host shows.
+ */
+#if defined(__AVR__)
+static const uint32_t NEX_POWERS[] PROGMEM = {1000000000UL, 100000000UL, 10000000UL, 1000000UL, 100000UL, 10000UL};
+static const uint16_t NEX_POWERS16[] PROGMEM = {1000, 100, 10};  // below 10000 the value fits 16 bits
+
+void nextion_ez::txNumber(uint32_t val){
+    bool started = false;               // no zeros before the first digit
+
+    for(uint8_t i = 0; i < sizeof(NEX_POWERS) / sizeof(NEX_POWERS[0]); i++){
+        uint32_t power = pgm_read_dword(&NEX_POWERS[i]);
+        if(val >= power || started){
+            char digit = '0';
+            while(val >= power){
+                val -= power;
+                digit++;
+            }
+            txChar(digit);
+            started = true;
+        }
+    }
+    uint16_t small = val;               // 16 bit subtractions are faster on 8 bit boards
+    for(uint8_t i = 0; i < sizeof(NEX_POWERS16) / sizeof(NEX_POWERS16[0]); i++){
+        uint16_t power = pgm_read_word(&NEX_POWERS16[i]);
+        if(small >= power || started){
+            char digit = '0';
+            while(small >= power){
+                small -= power;
+                digit++;
+            }
+            txChar(digit);
+            started = true;
+        }
+    }
+    txChar('0' + small);                // the last digit, also the 0 of a value 0
+}
+#else
+void nextion_ez::txNumber(uint32_t val){
+    char digits[10];                    // 4294967295 has 10 digits
+    uint8_t count = 0;
+    do{
+        digits[count++] = '0' + val % 10;
+        val /= 10;
+    }while(val > 0);
+    while(count > 0){
+        txChar(digits[--count]);
+    }
+}
+#endif
+
+void nextion_ez::txSigned(int32_t val){
+    if(val < 0){
+        txChar('-');
+        txNumber(0UL - (uint32_t)val);  // also right for -2147483648, that has no positive int32_t
+    }else{
+        txNumber(val);
+    }
+}
+
+void nextion_ez::txEnd(uint8_t ack){    // the end of every command
+    txChar(0xFF);
+    txChar(0xFF);
+    txChar(0xFF);
+    NEX_STAT(_stats.commands++);
+    
+    uint32_t key = _txKey;
+    _txKey = 0;
+    bool cached = _txCached;
+    _txCached = false;
+    if(key != 0 && _bulkUsed > 0){
+        bulkForget(key);                // an older value must not arrive after this one
+    }
+    if(_txPriority == NEX_PRIO_BULK && ack != NEX_ACK_GET && _txCmdBytes <= _txLen && bulkAdd(ack, key)){
+        _txCmdBytes = 0;                // it waits in the bulk queue, listen() sends it
+        if(cached) cacheKeep(key, NEX_CACHE_BULK);
+        return;
+    }                                   // a get never waits there, its reply must come in the order of the requests
+    if(ack != NEX_ACK_GET){
+        _writeCount++;
+    }
+    
+    if(_flowOn && ack != NEX_ACK_NONE){
+        if(flowFull(_txCmdBytes)){
+            flowWait();                 // room first, then our command
+        }
+        flowAdd(_txCmdBytes, ack == NEX_ACK_GET, key);
+        _flowUnsent++;                  // until txSend() writes it
+    }
+    _txCmdBytes = 0;
+    if(cached) cacheKeep(key, NEX_CACHE_HELD);
+    
+    if(!_txHold){
+        txSend();
+    }
+}
+//------------------------------------------------------------------------------
+/*
+ * -- readStr(String): We use it to read the value of every components' text attribute from Nextion (txt etc...)
+ * String = objectname.textAttribute (example: "t0.txt", "va0.txt", "b0.txt"...etc)
+ * Syntax: String x = myObject.readStr("t0.txt"); // Store to x the value of text box t0
+ * Returns "ERROR" if the reply did not arrive in time (see setRequestTimeout())
+ */
+String nextion_ez::readStr(const String& TextComponent){
+  NEX_GUARD();
+  
+  _readString = "";                     // the text of the reply is added here by parseByte()
+  
+  while(_reqCount >= NEXTION_EZ_REQUESTS){  // make room in the request queue
+    listen();
+  }
+  
+  // send a "get" command to Nextion and wait until listen() has read the reply
+  // in the following format:
+  // 0x70 ... (each character of the String is represented in HEX) ... 0xFF 0xFF 0xFF
+  
+  // Example: For the String ab123, we will receive: 0x70 0x61 0x62 0x31 0x32 0x33 0xFF 0xFF 0xFF
+  
+  _syncDone = false;
+  sendRequest(TextComponent.c_str(), 0x70, NULL, NULL, NEX_REQ_WAIT);
+  txSend();                             // also sends any commands held by beginBatch(), the batch goes on
+  while(_syncDone == false){            // listen() also handles any command that arrives meanwhile
+    listen();                           // and gives up on the request after the timeout
+  }
+  
+  if(_syncStatus != NEX_OK){
+    _readString = "ERROR";
+  }
+
+  return _readString;
+}
+//------------------------------------------------------------------------------
+/*
+ * -- readStr(char array, char* buffer, size_t size): the same as readStr(String) but the text goes to a char array
+ * of yours, without using the heap memory. Up to size - 1 characters are copied and a '\0' is added.
+ * Returns the length of the whole text, so if it is size or more, the text was cut.
+ * Returns -1 if the reply did not arrive in time or Nextion answered with an error.
+ * Syntax: | char name[20]; int len = myObject.readStr("t0.txt", name, sizeof(name)); |
+ */
+int nextion_ez::readStr(const char* component, char* buffer, size_t size){
+  NEX_GUARD();
+  _strBuf = buffer;
+  _strSize = size;
+  if(size > 0) buffer[0] = '\0';
+  
+  if(waitStr(component, NEX_REQ_BUFFER) != NEX_OK){
+    if(size > 0) buffer[0] = '\0';
+    return -1;
+  }
+  return _strLen;
+}
+//------------------------------------------------------------------------------
+/*
+ * -- readStr(char array, nextionChunkCallback): for long texts, hands the text to a function of yours
+ * in parts of up to NEXTION_EZ_STR_MAX characters, as they arrive. Nothing is kept in the memory.
+ * nextionChunkCallback = void name(const char* part, uint8_t length)   (the part has no '\0' at its end)
+ * Returns NEX_OK, NEX_TIMEOUT or NEX_ERROR. The parts already given are not valid if it is not NEX_OK.
+ * Syntax: | myObject.readStr("t0.txt", saveToSD); |
+ */
+uint8_t nextion_ez::readStr(const char* component, nextionChunkCallback callback){
+  NEX_GUARD();
+  _chunkCallback = callback;
+  return waitStr(component, NEX_REQ_CHUNKS);
+}
+//------------------------------------------------------------------------------
+/*
+ * -- waitStr(char array, uint8_t): sends the "get" of a text and waits for the reply, the text is
+ * taken by parseByte() in the way the request kind says
+ */
+uint8_t nextion_ez::waitStr(const char* component, uint8_t kind){
+  while(_reqCount >= NEXTION_EZ_REQUESTS){  // make room in the request queue
+    listen();
+  }
+  
+  _strLen = 0;
+  _syncDone = false;
+  sendRequest(component, 0x70, NULL, NULL, kind);
+  txSend();                             // the batch of beginBatch() goes on
+  while(_syncDone == false){
+    listen();
+  }
+  return _syncStatus;
+}
+//------------------------------------------------------------------------------
+/*
+ * -- readNumber(String): We use it to read the value of a components' numeric attribute on Nextion
+ * In every component's numeric attribute (value, bco color, pco color...etc)
+ * String = objectname.numericAttribute (example: "n0.val", "n0.pco", "n0.bco"...etc)
+ * Syntax: | myObject.readNumber("n0.val"); |  or  | myObject.readNumber("b0.bco");                       |
+ *         | read the value of numeric n0   |      | read the color number of the background of butoon b0 |
+ * Returns 777777 if the reply did not arrive in time (see setRequestTimeout())
+ */
+
+uint32_t nextion_ez::readNum(const String& component){
+    NEX_GUARD();
+    return readNum(component.c_str());
+}
+
+uint32_t nextion_ez::readNum(const char* component){
+  NEX_GUARD();
+  
+  while(_reqCount >= NEXTION_EZ_REQUESTS){  // make room in the request queue
+    listen();
+  }
+  
+  // send a "get" command to Nextion and wait until listen() has read the reply
+  // in the following format:
+  // 0x71 0x01 0x02 0x03 0x04 0xFF 0xFF 0xFF
+  // 0x01 0x02 0x03 0x04 is 4 byte 32-bit value in little endian order.
+  
+  _syncDone = false;
+  sendRequest(component, 0x71, NULL, NULL, NEX_REQ_WAIT);
+  return waitNum();
+}
+
+uint32_t nextion_ez::readNum(const nextionComponent& comp){  // handle made with NEX_COMPONENT()
+  NEX_GUARD();
+  
+  while(_reqCount >= NEXTION_EZ_REQUESTS){
+    listen();
+  }
+  
+  _syncDone = false;
+  addRequest(0x71, NULL, NULL, NEX_REQ_WAIT);
+  txFlash(comp.get, comp.length + 4);   // "get n0.val" is ready in flash
+  txEnd(NEX_ACK_GET);
+  return waitNum();
+}
+
+//------------------------------------------------------------------------------
+/*
+ * -- readInt(String): the same as readNum(), for signed values. Nextion keeps every number as a signed 32 bit value,
+ * so -40 comes back as -40 and not as 4294967256
+ * Syntax: | int32_t x = myObject.readInt("n0.val"); |
+ * Returns 777777 if the reply did not arrive in time, like readNum()
+ */
+int32_t nextion_ez::readInt(const String& component){
+    NEX_GUARD();
+    return (int32_t)readNum(component.c_str());
+}
+
+int32_t nextion_ez::readInt(const char* component){
+    NEX_GUARD();
+    return (int32_t)readNum(component);
+}
+
+int32_t nextion_ez::readInt(const nextionComponent& comp){
+    NEX_GUARD();
+    return (int32_t)readNum(comp);
+}
+//------------------------------------------------------------------------------
+uint32_t nextion_ez::waitNum(){         // the reply of the request just sent by readNum()
+  txSend();                             // also sends any commands held by beginBatch(), the batch goes on
+  while(_syncDone == false){
+    listen();
+  }
+  
+  if(_syncStatus != NEX_OK){
+    _numberValue = 777777;              // The function will return this number in case it fails to read the new number
+  }
+  
+  return _numberValue;
+}
+//------------------------------------------------------------------------------
+/*
+ * -- readNums(names, values, status, count, timeout): reads many numeric attributes in one go
+ * const char* names[] = the objectname.numericAttribute of each value (example: {"n0.val", "n1.val", "h0.val"})
+ * uint32_t values[]   = where the values are stored, in the same order
+ * uint8_t status[]    = NEX_OK, NEX_ERROR or NEX_TIMEOUT for each value, or NULL if not needed
+ * uint8_t count       = how many values
+ * unsigned long timeout = the time (ms) for all of them together
+ * All the "get" commands are sent one after the other without waiting, and the replies are
+ * collected as they come, so 12 values cost about one wait instead of 12.
+ * Returns how many values were read correctly. Values that could not be read, or were never sent
+ * because the time was over, are 777777; with status NULL the count still tells how many are good.
+ * Syntax: | uint8_t ok = myObject.readNums(names, values, NULL, 12, 1000); |
+ */
+uint8_t nextion_ez::readNums(const char* const names[], uint32_t values[], uint8_t status[], uint8_t count, unsigned long timeout){
+  NEX_GUARD();
+  
+  txSend();                             // a get held by beginBatch() must go to be answered
+  while(_reqCount > 0){                 // the replies of older requests come first
+    listen();
+  }
+  
+  _batchValues = values;
+  _batchStatus = status;
+  _batchDone = 0;
+  _batchGood = 0;
+  
+  uint8_t sent = 0;
+  unsigned long start = millis();
+  bool hold = _txHold;                  // a batch of the caller goes on after readNums()
+  
+  while(_batchDone < count){
+    if(sent < count){
+      _txHold = true;                   // send as many gets as the queue can take, with one write
+      while(sent < count && _reqCount < NEXTION_EZ_REQUESTS){
+        sendRequest(names[sent], 0x71, NULL, NULL, NEX_REQ_BATCH);
+        sent++;
+      }
+      _txHold = hold;
+      txSend();
+    }
+    
+    listen();
+    
+    if((millis() - start) > timeout){   // the time for the whole batch is over
+      while(_batchDone < sent){
+        finishRequest(NEX_TIMEOUT);     // the gets that got no reply
+      }
+      while(_batchDone < count){        // and the ones that were never sent
+        values[_batchDone] = 777777;
+        if(status != NULL) status[_batchDone] = NEX_TIMEOUT;
+        _batchDone++;
+      }
+    }
+  }
   
- int _tempInt = _serial->read(); 
+  _batchValues = NULL;
+  return _batchGood;                    // counted from the status, a value can really be 777777
+}
+//------------------------------------------------------------------------------
+/*
+ * -- requestNum(String, nextionNumCallback): the same as readNum() but it does NOT wait for the reply
+ * String = objectname.numericAttribute (example: "n0.val", "n0.pco", "n0.bco"...etc)
+ * nextionNumCallback = a function of yours: void name(uint8_t status, uint32_t value)
+ * The "get" command is sent at once and the function returns. The reply is read by listen(),
+ * which then calls your function. status is NEX_OK when value is valid, NEX_TIMEOUT if no reply came
+ * in time, or NEX_ERROR if Nextion did not accept the command (for example a wrong component name).
+ * Nextion does not say which command an error is for. If writes sent before the get may still be running,
+ * the error could be theirs, so it only goes to getLastError() and a wrong name ends with NEX_TIMEOUT.
+ * With useFlowControl(true) every answer is matched to its command and NEX_ERROR is always given.
+ * Returns false if too many requests are already waiting (see NEXTION_EZ_REQUESTS).
+ * Syntax: | myObject.requestNum("n0.val", gotNumber); |
+ */
+bool nextion_ez::requestNum(const String& component, nextionNumCallback callback){
+    NEX_GUARD();
+    return sendRequest(component.c_str(), 0x71, callback, NULL, NEX_REQ_CALLBACK);
+}
+
+bool nextion_ez::requestNum(const char* component, nextionNumCallback callback){
+    NEX_GUARD();
+    return sendRequest(component, 0x71, callback, NULL, NEX_REQ_CALLBACK);
+}
+
+bool nextion_ez::requestNum(const nextionComponent& comp, nextionNumCallback callback){
+    NEX_GUARD();
+    if(!addRequest(0x71, callback, NULL, NEX_REQ_CALLBACK)){
+        return false;
+    }
+    txFlash(comp.get, comp.length + 4);
+    txEnd(NEX_ACK_GET);
+    return true;
+}
+//------------------------------------------------------------------------------
+/*
+ * -- requestStr(String, nextionStrCallback): the same as readStr() but it does NOT wait for the reply
+ * String = objectname.textAttribute (example: "t0.txt", "va0.txt", "b0.txt"...etc)
+ * nextionStrCallback = a function of yours: void name(uint8_t status, const char* text)
+ * Text longer than NEXTION_EZ_STR_MAX characters is cut. Copy the text if you need it later.
+ * Syntax: | myObject.requestStr("t0.txt", gotText); |
+ */
+bool nextion_ez::requestStr(const String& component, nextionStrCallback callback){
+    NEX_GUARD();
+    return sendRequest(component.c_str(), 0x70, NULL, callback, NEX_REQ_CALLBACK);
+}
+
+bool nextion_ez::requestStr(const char* component, nextionStrCallback callback){
+    NEX_GUARD();
+    return sendRequest(component, 0x70, NULL, callback, NEX_REQ_CALLBACK);
+}
+//------------------------------------------------------------------------------
+int nextion_ez::pendingRequests(){  //returns the number of requests still waiting for a reply
+    NEX_GUARD();
+    return _reqCount;
+}
+//------------------------------------------------------------------------------
+void nextion_ez::setRequestTimeout(unsigned long timeout){  // how long (ms) a request waits for its reply
+    NEX_GUARD();
+    _reqTimeout = timeout;
+}
+//------------------------------------------------------------------------------
+int nextion_ez::getLastError(){     //returns the last error code Nextion sent (0x1A, 0x24...), 0 if none
+    NEX_GUARD();
+    return _lastError;
+}
+//------------------------------------------------------------------------------
+bool nextion_ez::addRequest(uint8_t code, nextionNumCallback numCallback, nextionStrCallback strCallback, uint8_t kind){
+    if(_reqCount >= NEXTION_EZ_REQUESTS){
+        return false;                   // the queue is full
+    }
+
+    request* req = &_requests[_reqHead];
+    req->code = code;
+    req->kind = kind;
+    req->numCallback = numCallback;
+    req->strCallback = strCallback;
+    req->sent = millis();
+    req->writes = _writeCount;          // the get goes out right after this
+
+    _reqHead++;
+    if(_reqHead >= NEXTION_EZ_REQUESTS) _reqHead = 0;
+    _reqCount++;
+    return true;
+}
+
+bool nextion_ez::sendRequest(const char* component, uint8_t code, nextionNumCallback numCallback, nextionStrCallback strCallback, uint8_t kind){
+    if(!addRequest(code, numCallback, strCallback, kind)){
+        return false;
+    }
+    txText("get ");
+    txText(component);
+    txEnd(NEX_ACK_GET);
+    return true;
+}
+//------------------------------------------------------------------------------
+void nextion_ez::finishRequest(uint8_t status){
+    if(_reqCount == 0){
+        return;                         // a late reply, nobody is waiting for it
+    }
+
+    if(status == NEX_TIMEOUT){
+        NEX_STAT(_stats.requestTimeouts++);
+        if(_lateDropped){
+            _lateDropped = false;       // its reply was probably dropped as a late one, nothing more comes
+        }else if(_lateReplies < 255){
+            _lateReplies++;             // Nextion may still answer, that reply is not for the next get
+        }
+    }
+
+    request req = _requests[_reqTail];  // take it out of the queue first, the callback may send a new request
+    _reqTail++;
+    if(_reqTail >= NEXTION_EZ_REQUESTS) _reqTail = 0;
+    _reqCount--;
+
+    if(status == NEX_OK && (_frameCode != req.code || (req.code == 0x71 && _frameCount != 4))){
+        status = NEX_ERROR;             // this is not the reply we were waiting for
+    }
+    if(status == NEX_OK){
+        _writesAnswered = req.writes;   // Nextion runs the commands in order, the ones before the get are done
+        _lateDropped = false;
+    }
+
+    if(req.code == 0x71){
+        uint32_t value = 0;
+        if(status == NEX_OK){
+            value = _frameBuf[3];
+            value <<= 8;
+            value |= _frameBuf[2];
+            value <<= 8;
+            value |= _frameBuf[1];
+            value <<= 8;
+            value |= _frameBuf[0];
+        }
+        if(req.kind == NEX_REQ_WAIT){
+            _numberValue = value;
+        }else if(req.kind == NEX_REQ_BATCH){
+            _batchValues[_batchDone] = (status == NEX_OK) ? value : 777777;  // the replies come in the order the gets were sent
+            if(_batchStatus != NULL) _batchStatus[_batchDone] = status;
+            if(status == NEX_OK) _batchGood++;
+            _batchDone++;
+        }else if(req.numCallback != NULL){
+            req.numCallback(status, value);
+        }
+    }else if(req.kind == NEX_REQ_CALLBACK){
+        uint8_t len = (_frameCount < NEXTION_EZ_STR_MAX) ? _frameCount : NEXTION_EZ_STR_MAX;
+        if(status != NEX_OK) len = 0;
+        _frameBuf[len] = '\0';
+        if(req.strCallback != NULL) req.strCallback(status, (const char*)_frameBuf);
+    }else if(req.kind == NEX_REQ_CHUNKS && status == NEX_OK && _frameCount > 0){
+        if(_chunkCallback != NULL) _chunkCallback((const char*)_frameBuf, _frameCount);  // the last part
+    }
+
+    if(req.kind == NEX_REQ_WAIT || req.kind == NEX_REQ_BUFFER || req.kind == NEX_REQ_CHUNKS){
+        _syncStatus = status;
+        _syncDone = true;
+    }
+}
+//------------------------------------------------------------------------------
+/*
+ * -- readByte(): Main purpose and usage is for the custom commands read
+ * Where we need to read bytes from Serial inside user code
+ * The bytes of the last command found by listen() are returned, then -1.
+ * The Serial is not read: its bytes belong to the next frames of listen()
+ */
 
- return _tempInt;
+int  nextion_ez::readByte(){
+  NEX_GUARD();
+  
+ if(_cmdRead < _cmdCount){
+   return _cmdBuf[_cmdRead++];
+ }
+ 
+ return -1;
   
 }
 //------------------------------------------------------------------------------
@@ -400,46 +2619,440 @@ int  nextion_ez::readByte(){
  * -- listen(): It uses a custom protocol to identify commands from Nextion Touch Events
  * For advanced users: You can modify the custom protocol to add new group commands.
  * More info on custom protocol: https://seithan.com/Easy-Nextion-Library/Custom-Protocol/ and on the documentation of the library
+ * listen() only reads the bytes that are already in the Serial buffer and never waits for more.
+ * A command that is only partly here is kept and finished by the next call.
  */
 /*! WARNING: This function must be called repeatedly to response touch events
  * from Nextion touch panel. 
  * Actually, you should place it in your loop function.
  */
 void nextion_ez::listen(){
-	if(_serial->available() > 2){         // Read if more then 2 bytes come (we always send more than 2 <#> <len> <cmd> <id>
-    _start_char = _serial->read();      // Create a local variable (start_char) read and store the first byte on it  
-    _tmr1 = millis();
-    
-    while(_start_char != '#'){            
-      _start_char = _serial->read();        // whille the start_char is not the start command symbol 
-                                           //  read the serial (when we read the serial the byte is deleted from the Serial buffer)
-      if((millis() - _tmr1) > 100UL){     //   Waiting... But not forever...... 
-        break;                            
-      }   
-    }
-    if(_start_char == '#'){            // And when we find the character #
-      _len = _serial->read();          //  read and store the value of the second byte
-                                       // <len> is the lenght (number of bytes following) 
-      _tmr1 = millis();
-      _cmdFound = true;
+  NEX_GUARD();
+#if NEXTION_EZ_STATS
+  unsigned long start = micros();
+#endif
+  int count = rxAvailable();            // only the bytes already here, so every call is short
+  
+  if(_rxState != NEX_RX_IDLE && count == 0 && (millis() - _frameTime) > 100UL){
+    _rxState = NEX_RX_IDLE;             // the rest of the frame never came, forget it
+    NEX_STAT(_stats.droppedFrames++);
+  }
+  
+  while(count > 0){                     // a callback of parseByte() may call listen() (readNum()...) and take
+    int c = rxRead();                   // some of these bytes, so each one is checked
+    if(c < 0){
+      break;
+    }
+    parseByte((uint8_t)c);
+    NEX_STAT(_stats.rxBytes++);
+    count--;
+  }
+  
+  if(_reqCount > 0 && (millis() - _requests[_reqTail].sent) > _reqTimeout){
+    if(_rxState != NEX_RX_NATIVE || (_frameCode != 0x70 && _frameCode != 0x71)){  // not while the reply is arriving
+      finishRequest(NEX_TIMEOUT);       // the oldest request waited too long
+    }
+  }
+  
+#if NEXTION_EZ_WINDOW > 0
+  if(_flowCount > 0 && (millis() - _flow[_flowTail].sent) > _reqTimeout){
+    flowDone(NEX_TIMEOUT);              // the oldest command got no answer
+    NEX_STAT(_stats.flowTimeouts++);
+  }
+#endif
+  
+  if(_waveState == NEX_WAVE_READY && (millis() - _waveTime) > 500UL){
+    waveFailed();                       // no answer to addt, give up on this block
+  }
+  if(_waveState == NEX_WAVE_DONE && (millis() - _waveTime) > 500UL){
+    _waveState = NEX_WAVE_IDLE;         // the data was sent, only its 0xFD is missing
+  }
+  if(_waveState == NEX_WAVE_IDLE){
+    startWave();                        // a waveform block of streamWave() is ready to go
+  }
+  if(_bulkUsed > 0){
+    sendBulk();                         // the commands of setPriority(NEX_PRIO_BULK)
+  }
+#if NEXTION_EZ_TRACE
+  traceEnd();                           // the bytes of this call as one record
+#endif
+  
+#if NEXTION_EZ_STATS
+  unsigned long time = micros() - start;
+  if(time > _stats.listenMaxUs){
+    _stats.listenMaxUs = time;
+  }
+  if(_statsCallback != NULL && (millis() - _statsTime) >= _statsInterval){
+    _statsTime = millis();
+    _statsCallback(_stats);
+  }
+#endif
+}
+//------------------------------------------------------------------------------
+/*
+ * -- pump(): moves the bytes that are waiting in the Serial to the receive ring of the library.
+ * The Serial of an Arduino Uno or Mega keeps only 64 bytes, so when the loop is busy for long
+ * (sensors, SD card...) touch events and replies are lost. With NEXTION_EZ_RX_SIZE set to, say, 256,
+ * call pump() from the slow code, from serialEvent() or from a timer interrupt, and listen(),
+ * readNum() and readStr() take the bytes from the ring. With NEXTION_EZ_RX_SIZE 0 it does nothing.
+ * listen() calls pump() too. If the interrupt comes while the loop is inside pump(), the interrupt
+ * returns at once and the loop takes the bytes, so the ring has only one writer at a time.
+ * Not from an interrupt on an ESP32: its HardwareSerial cannot be read there, use beginTask() instead.
+ * Syntax: | myObject.pump(); |
+ */
+void nextion_ez::pump(){
+#if NEXTION_EZ_RX_SIZE > 0
+  NEX_GUARD();
+  if(_pumping){
+    return;                             // we interrupted the pump() of the loop, it takes the bytes
+  }
+  _pumping = true;
+  uint16_t head = _rxHead;              // only pump() changes the head
+  while(_serial->available() > 0){
+    uint16_t next = head + 1;
+    if(next >= NEXTION_EZ_RX_SIZE) next = 0;
+    if(next == _rxTail){
+      break;                            // the ring is full, the bytes wait in the Serial
+    }
+    _rxBuf[head] = (uint8_t)_serial->read();
+    head = next;
+  }
+  _rxHead = head;
+
+  uint16_t used = (head >= _rxTail) ? head - _rxTail : head + NEXTION_EZ_RX_SIZE - _rxTail;
+  if(used > _rxHighWater) _rxHighWater = used;
+  if(used == NEXTION_EZ_RX_SIZE - 1 && _serial->available() > 0){
+    _rxOverruns++;                      // the Serial may overflow next, count it as a warning
+  }
+  _pumping = false;
+#endif
+}
+//------------------------------------------------------------------------------
+/*
+ * -- rxHighWater(): the most bytes that ever waited in the receive ring (or NEXTION_EZ_RX_SIZE 0: in the Serial,
+ * as seen by listen()). Close to the size means that pump() or listen() must be called more often.
+ * rxOverruns(): how many times pump() found the ring full while more bytes were waiting in the Serial
+ * Syntax: | Serial.println(myObject.rxHighWater()); |
+ */
+int nextion_ez::rxHighWater(){
+  NEX_GUARD();
+  return _rxHighWater;
+}
+
+uint32_t nextion_ez::rxOverruns(){
+  NEX_GUARD();
+  return _rxOverruns;
+}
+//------------------------------------------------------------------------------
+/*
+ * -- rxAvailable(), rxRead(), rxClear(): the received bytes, from the ring of pump() or straight from the Serial.
+ * rxRead() also gives them to the trace of traceTo(), so bytes are recorded when the library takes them.
+ * pump() may run in an interrupt and change the head, so on 8 bit boards the 16 bit head and tail are used with the interrupts off.
+ */
+int nextion_ez::rxAvailable(){
+#if NEXTION_EZ_RX_SIZE > 0
+  pump();
+  return rxCount();
+#else
+  int count = _serial->available();
+  if(count > _rxHighWater) _rxHighWater = count;
+  return count;
+#endif
+}
+
+int nextion_ez::rxRead(){
+#if NEXTION_EZ_RX_SIZE > 0
+  if(rxCount() == 0){
+    pump();
+    if(rxCount() == 0){
+      return -1;
+    }
+  }
+  int c = _rxBuf[_rxTail];
+  uint16_t next = _rxTail + 1;
+  if(next >= NEXTION_EZ_RX_SIZE) next = 0;
+  #ifdef __AVR__
+  uint8_t sreg = SREG;
+  cli();
+  #endif
+  _rxTail = next;
+  #ifdef __AVR__
+  SREG = sreg;
+  #endif
+#else
+  int c = _serial->read();
+#endif
+#if NEXTION_EZ_TRACE
+  if(c >= 0){
+    traceByte(false, (uint8_t)c);
+  }
+#endif
+  return c;
+}
+
+#if NEXTION_EZ_RX_SIZE > 0
+uint16_t nextion_ez::rxCount(){
+  #ifdef __AVR__
+  uint8_t sreg = SREG;
+  cli();
+  #endif
+  uint16_t head = _rxHead;
+  #ifdef __AVR__
+  SREG = sreg;
+  #endif
+  return (head >= _rxTail) ? head - _rxTail : head + NEXTION_EZ_RX_SIZE - _rxTail;
+}
+#endif
+
+void nextion_ez::rxClear(){
+#if NEXTION_EZ_RX_SIZE > 0
+  _rxHead = 0;
+  _rxTail = 0;
+  _pumping = false;
+#endif
+}
+//------------------------------------------------------------------------------
+/*
+ * -- frameLength(uint8_t): the number of data bytes that follow a Nextion return code,
+ * before the 0xFF 0xFF 0xFF end. NEX_LEN_VARIABLE for replies that end at the first 0xFF 0xFF 0xFF
+ * and NEX_LEN_UNKNOWN for bytes that are not a return code.
+ */
+static uint8_t frameLength(uint8_t code){
+  switch(code){
+    case 0x70:                          // string data
+      return NEX_LEN_VARIABLE;
+    case 0x00:                          // invalid instruction, also 0x00 0x00 0x00 at start up (see parseByte())
+    case 0x01:                          // instruction successful
+    case 0x02: case 0x03: case 0x04:    // invalid component, page or picture id
+    case 0x05: case 0x06: case 0x09:    // invalid font id, file operation or CRC
+    case 0x11: case 0x12:               // invalid baud rate, waveform id or channel
+    case 0x1A: case 0x1B: case 0x1C:    // invalid variable name, variable operation, assignment failed
+    case 0x1D: case 0x1E: case 0x1F:    // EEPROM failed, invalid quantity of parameters, IO failed
+    case 0x20:                          // escape character invalid
+    case 0x24:                          // serial buffer overflow
+    case 0x86: case 0x87:               // auto sleep, auto wake up
+    case 0x88: case 0x89:               // Nextion ready, start microSD upgrade
+    case 0xFD: case 0xFE:               // transparent data finished, transparent data ready
+      return 0;
+    case 0x66:                          // current page number
+      return 1;
+    case 0x65:                          // touch event: page, component, event
+      return 3;
+    case 0x71:                          // numeric data, 4 bytes little endian
+      return 4;
+    case 0x67: case 0x68:               // touch coordinate: x, y, event
+      return 5;
+    default:
+      return NEX_LEN_UNKNOWN;
+  }
+}
+//------------------------------------------------------------------------------
+/*
+ * -- parseByte(uint8_t): a small state machine that is fed one byte at a time by listen()
+ * It knows two kinds of frames:
+ * <#> <len> <cmd> <id> <id2>...            the custom protocol, sent with printh from Nextion
+ * <code> <data>... 0xFF 0xFF 0xFF          the return data of Nextion itself (replies, touch, errors)
+ * As it keeps its place between calls, nothing is lost when a frame arrives in pieces.
+ */
+void nextion_ez::parseByte(uint8_t c){
+  _frameTime = millis();
+  
+  switch(_rxState){
+    case NEX_RX_IDLE:                   // looking for the start of a frame
+      if(c == '#'){
+        _rxState = NEX_RX_LEN;
+      }else{
+        uint8_t len = frameLength(c);
+        if(len != NEX_LEN_UNKNOWN){
+          _frameCode = c;
+          _frameLen = len;
+          _frameCount = 0;
+          _frameEnd = 0;
+          _rxState = NEX_RX_NATIVE;
+        }else{
+          NEX_STAT(_stats.skippedBytes++);  // a byte out of any frame, skip it
+        }
+      }
+      break;
+      
+    case NEX_RX_LEN:                    // <len> is the lenght (number of bytes following)
+      _len = c;
+      _rxCmdCount = 0;
+      _rxState = (_len > 0) ? NEX_RX_CMD : NEX_RX_IDLE;
+      break;
+      
+    case NEX_RX_CMD:                    // the <len> bytes of a custom command
+      if(_rxCmdCount < NEXTION_EZ_CMD_MAX){
+        _rxCmd[_rxCmdCount] = c;        // the whole command is kept, up to NEXTION_EZ_CMD_MAX bytes
+      }
+      _rxCmdCount++;
+      if(_rxCmdCount >= _len){
+        _rxState = NEX_RX_IDLE;
+        _cmd1 = _rxCmd[0];              // the command group
+        readCommand();                  // in which we read, seperate and execute the commands 
+      }
+      break;
+      
+    case NEX_RX_NATIVE:                 // the data of a Nextion return code
+      if(_frameLen != NEX_LEN_VARIABLE && _frameCount < _frameLen){
+        _frameBuf[_frameCount++] = c;   // fixed length data may contain 0xFF
+        break;
+      }
+      
+      if(c == 0xFF){
+        _frameEnd++;
+        if(_frameEnd == 3){
+          _rxState = NEX_RX_IDLE;
+          readReply();
+        }
+        break;
+      }
+      
+      if(_frameCode == 0x00 && c == 0x00 && _frameEnd == 0){
+        break;                          // the 0x00 0x00 0x00 Nextion sends at start up, one frame
+      }
+      
+      if(_frameEnd > 0 || _frameLen != NEX_LEN_VARIABLE){
+        _rxState = NEX_RX_IDLE;         // a broken frame, this byte may be the start of the next one
+        NEX_STAT(_stats.droppedFrames++);
+        parseByte(c);
+        break;
+      }
+      
+      if(_frameCount < NEXTION_EZ_STR_MAX){
+        _frameBuf[_frameCount] = c;
+      }
+      if(_frameCount < 255) _frameCount++;
+      
+      if(_frameCode == 0x70 && _reqCount > 0 && _lateReplies == 0){
+        takeText(c);                    // readStr() is waiting, it can take text of any length (not a late reply)
+      }
+      break;
+  }
+}
+//------------------------------------------------------------------------------
+/*
+ * -- takeText(uint8_t): a character of a text reply, for the readStr() that is waiting
+ */
+void nextion_ez::takeText(uint8_t c){
+  switch(_requests[_reqTail].kind){
+    case NEX_REQ_WAIT:
+      _readString += (char)c;
+      break;
+      
+    case NEX_REQ_BUFFER:                // readStr() into a char array
+      if(_strLen + 1 < _strSize){
+        _strBuf[_strLen] = c;
+        _strBuf[_strLen + 1] = '\0';
+      }
+      _strLen++;
+      break;
+      
+    case NEX_REQ_CHUNKS:                // readStr() with a callback, a part is given when _frameBuf is full
+      if(_frameCount >= NEXTION_EZ_STR_MAX){
+        if(_chunkCallback != NULL) _chunkCallback((const char*)_frameBuf, NEXTION_EZ_STR_MAX);
+        _frameCount = 0;
+      }
+      break;
+  }
+}
+//------------------------------------------------------------------------------
+/*
+ * -- readReply(): called when a whole Nextion return frame has arrived
+ */
+void nextion_ez::readReply(){
+#if NEXTION_EZ_STATS
+  countFrame();
+#endif
+  switch(_frameCode){
+    case 0x70:                          // the reply of a "get" command
+    case 0x71:
+      if(_lateReplies > 0){             // the reply of a get that timed out: its request and its answer
+        _lateReplies--;                 // of the flow window are already finished
+        _lateDropped = true;
+        NEX_STAT(_stats.lateReplies++);
+        break;
+      }
+      if(_flowOn) flowDone(NEX_OK);     // with bkcmd=3 the data is the answer of the get
+      finishRequest(NEX_OK);
+      break;
+      
+    case 0x66:                          // the reply of "sendme", the current page number
+      if(_flowOn) flowDone(NEX_OK);
+      _gotPage = true;
+      _lastCurrentPageId = _currentPageId;
+      _currentPageId = _frameBuf[0];
+      clearCache();
+      sendPaged();
+      break;
+      
+    case 0x65:                          // touch event, when "Send Component ID" is checked
+    case 0x67:                          // touch coordinate (awake)
+    case 0x68:                          // touch coordinate (in sleep)
+    case 0x86:                          // Nextion entered sleep mode
+    case 0x87:                          // Nextion woke up
+    case 0x88:                          // Nextion is ready after power on
+#if NEXTION_EZ_NATIVE_EVENTS
+      _rxCmd[0] = _frameCode;           // handed to the main code like a custom command,
+      for(uint8_t i = 0; i < _frameCount && i + 1 < NEXTION_EZ_CMD_MAX; i++){  // getCmd() is the return code
+        _rxCmd[i + 1] = _frameBuf[i];   // and readByte() the data
+      }
+      addEvent(_frameCount + 1);
+#endif
+      if(_frameCode == 0x88){
+        clearCache();                   // Nextion started again with the values of the HMI file
+      }
+      if(_frameCode >= 0x86){
+        setAsleep(_frameCode == 0x86);
+      }
+      break;
+      
+    case 0xFE:                          // transparent data ready, the data of streamWave() can go
+      if(_waveState == NEX_WAVE_READY){
+        sendWaveData();
+      }
+      break;
+      
+    case 0xFD:                          // transparent data finished
+      if(_waveState == NEX_WAVE_DONE){
+        _waveState = NEX_WAVE_IDLE;
+      }
+      break;
+      
+    case 0x01:                          // instruction successful (only with bkcmd=1 or 3)
+      if(_flowOn) flowDone(NEX_OK);
+      break;
+      
+    case 0x89:
+      break;
       
-      while(_serial->available() < _len){     // Waiting for all the bytes that we declare with <len> to arrive              
-        if((millis() - _tmr1) > 100UL){         // Waiting... But not forever...... 
-          _cmdFound = false;                  // tmr_1 a timer to avoid the stack in the while loop if there is not any bytes on _serial
-          break;                            
-        }                                     
-      }                                   
-  
-      if(_cmdFound == true){                  // So..., A command is found (bytes in _serial buffer egual more than len)
-        _cmd1 = _serial->read();              // Read and store the next byte. This is the command group
-        readCommand();                        // We call the readCommand(), 
-                                              // in which we read, seperate and execute the commands 
-			}
-		}
-	}
+    default:                            // an error code
+      _lastError = _frameCode;
+      if(_waveState == NEX_WAVE_READY && (_frameCode == 0x00 || _frameCode == 0x02 || _frameCode == 0x12)){
+        waveFailed();                   // the answer of addt instead of 0xFE, it is not counted by the flow window
+        break;                          // (an 0x1A is for an earlier write, that addt still gets its 0xFE)
+      }
+      if(!_flowOn || _frameCode == 0x24){
+        clearCache();                   // the failed write is not known (0x24: bytes were lost), no value is sure
+      }
+      if(_flowOn){
+        flowDone(NEX_ERROR);            // we know exactly which command failed
+      }else if(_reqCount > 0 && _requests[_reqTail].writes == _writesAnswered &&
+               (_frameCode == 0x00 || _frameCode == 0x1A || _frameCode == 0x1B || _frameCode == 0x24)){
+        finishRequest(NEX_ERROR);       // the "get" was not accepted, no other command can have failed
+      }                                 // otherwise it may be a write sent before the get: only getLastError() tells,
+      break;                            // and the get waits for its reply or its timeout
+  }
 }
 //------------------------------------------------------------------------------
 void nextion_ez::readCommand(){
+#if NEXTION_EZ_STATS
+  if(_cmd1 == 'P'){
+    _stats.pageFrames++;
+  }else{
+    _stats.customFrames++;
+  }
+#endif
 
 				
   switch(_cmd1){
@@ -452,14 +3065,13 @@ void nextion_ez::readCommand(){
                *  it is importand to let the Arduino "Know" when and which Page change.
                */
       _lastCurrentPageId = _currentPageId;
-      _currentPageId = _serial->read();                   
+      _currentPageId = _rxCmd[1];
+      clearCache();                     // a new page is loaded with the values of the HMI file
+      sendPaged();                      // and the values kept by onPage() can go now
       break;
         
-    default:            //custom commands can be variable length, we pull just the first and leave the rest for main code to deal with 
-      _cmdGroup = _cmd1;  // stored in the public variable cmdGroup for later use in the main code
-      _cmdLength = _len;  // stored in the public variable cmdLength for later use in the main code
-      _cmdAvail = true;
-                    
+    default:            //custom commands can be variable length, the bytes are kept for readByte()
+      addEvent(_len);     // to the handler of onCommand(), or to the queue of cmdAvail()
       break;
                
             /*   More for custom protocol and commands https://seithan.com/Easy-Nextion-Library/Custom-Protocol/
@@ -478,7 +3090,7 @@ void nextion_ez::readCommand(){
       <id2> a second property of the command
       
       When we send a custom command with the above format, the function NextionListen() will capture the start marker # and the len (first 2 bytes)
-      and it will wait until all the bytes of the command, as we have declared with the len byte, arrive to the Serial buffer and inside the timeout limits.
+      and it will collect all the bytes of the command, as we have declared with the len byte, over as many calls as it takes for them to arrive.
       
       After that, the function will read the next byte, which is the command group and the function readCommand() takes over and through a switch command
       tries to match the _cmd variable that holds the command group value with the statements of the cases.
@@ -494,3 +3106,127 @@ void nextion_ez::readCommand(){
   }
 }
 
+
+//-------------------------------------------------------------------------
+ // nextionReplay : a trace of traceTo() played again as a Stream
+//---------------------------------------------------------------------------
+
+nextionReplay::nextionReplay(const uint8_t* trace, size_t length, uint8_t speed){
+  _trace = trace;
+  _length = length;
+  _speed = speed;
+  _started = false;
+  _due = 0;
+  _rxPos = 0;
+  _rxLeft = 0;
+  _txPos = 0;
+  _txLeft = 0;
+  _sent = 0;
+  _sentBefore = 0;
+  _mismatches = 0;
+}
+//------------------------------------------------------------------------------
+/*
+ * -- available(): the bytes left in the current received record, once its time has come.
+ * The clock starts at the first call, speed 10 plays 10 times faster, speed 0 does not wait.
+ * A record is only given after the library has sent as many bytes as were sent before it in the trace,
+ * so a reply never comes before its "get", and begin() does not empty the whole trace.
+ */
+int nextionReplay::available(){
+  if(!_started){
+    _started = true;
+    _start = millis();
+  }
+  nextRx();
+  if(_rxLeft == 0 || _sent < _sentBefore){
+    return 0;
+  }
+  if(_speed > 0 && (millis() - _start) < _due / _speed){
+    return 0;                           // this record came later
+  }
+  return _rxLeft;
+}
+
+int nextionReplay::read(){
+  if(available() <= 0){
+    return -1;
+  }
+  _rxLeft--;
+  return _trace[_rxPos++];
+}
+
+int nextionReplay::peek(){
+  if(available() <= 0){
+    return -1;
+  }
+  return _trace[_rxPos];
+}
+//------------------------------------------------------------------------------
+/*
+ * -- write(uint8_t): a byte of the library, compared with the next sent byte of the trace
+ */
+size_t nextionReplay::write(uint8_t c){
+  _sent++;
+  nextTx();
+  if(_txLeft == 0 || _trace[_txPos] != c){
+    _mismatches++;
+  }
+  if(_txLeft > 0){
+    _txPos++;
+    _txLeft--;
+  }
+  return 1;
+}
+//------------------------------------------------------------------------------
+/*
+ * -- done(): true when every received byte of the trace has been read
+ * Syntax: | while(!replay.done()){ myNex.listen(); } |
+ */
+bool nextionReplay::done(){
+  nextRx();
+  return _rxLeft == 0;
+}
+//------------------------------------------------------------------------------
+/*
+ * -- txMismatches(): sent bytes that were not the same as in the trace, 0 when the sketch did the same writes
+ * Syntax: | Serial.println(replay.txMismatches()); |
+ */
+uint32_t nextionReplay::txMismatches(){
+  return _mismatches;
+}
+//------------------------------------------------------------------------------
+/*
+ * -- nextRx(), nextTx(): move to the next record of received or sent bytes, once the current one is used.
+ * nextRx() adds the time of every record it passes, the time of the first record is not waited for.
+ */
+void nextionReplay::nextRx(){
+  while(_rxLeft == 0 && _rxPos + NEX_TRACE_HEADER <= _length){
+    uint8_t head = _trace[_rxPos];
+    if(_rxPos > 0){
+      _due += _trace[_rxPos + 1] | ((uint16_t)_trace[_rxPos + 2] << 8);
+    }
+    _rxPos += NEX_TRACE_HEADER;
+    uint8_t length = head & NEX_TRACE_LENGTH;
+    if(length > _length - _rxPos) length = _length - _rxPos;  // a trace that was cut
+    if(head & NEX_TRACE_SENT){
+      _rxPos += length;                 // sent bytes, for nextTx()
+      _sentBefore += length;
+    } else {
+      _rxLeft = length;
+    }
+  }
+}
+
+void nextionReplay::nextTx(){
+  while(_txLeft == 0 && _txPos + NEX_TRACE_HEADER <= _length){
+    uint8_t head = _trace[_txPos];
+    _txPos += NEX_TRACE_HEADER;
+    uint8_t length = head & NEX_TRACE_LENGTH;
+    if(length > _length - _txPos) length = _length - _txPos;
+    if(head & NEX_TRACE_SENT){
+      _txLeft = length;
+    } else {
+      _txPos += length;                 // received bytes, for nextRx()
+    }
+  }
+}
@@ -5,7 +5,7 @@
  * All rights reserved under the library's licence
  */
 
-#if ARDUINO >= 100    
+#if !defined(ARDUINO) || ARDUINO >= 100    // without ARDUINO (a PC build) the Arduino.h of extras/host, or one of your own
  #include "Arduino.h"
 #else
  #include "WProgram.h"
@@ -17,8 +17,198 @@
 #ifndef nextion_ez_h
 #define nextion_ez_h
 
+  //------------------------------------------------------
+ // sizes of the buffers of the library. The ones of the optional features are 0 by default,
+ // then the feature is not compiled and costs no RAM: set them here or in the build flags
+//--------------------------------------------------------
+#ifndef NEXTION_EZ_REQUESTS
+#define NEXTION_EZ_REQUESTS 4     // how many requests can wait for a reply at the same time (at least 1)
+#endif
+
+#ifndef NEXTION_EZ_STR_MAX
+#define NEXTION_EZ_STR_MAX 32     // longest text a requestStr() reply can return, longer text is cut
+#endif
+
+#ifndef NEXTION_EZ_TX_SIZE
+#define NEXTION_EZ_TX_SIZE 64     // transmit buffer, each command is built here and sent with one write()
+#endif
+
+#ifndef NEXTION_EZ_CACHE
+#define NEXTION_EZ_CACHE 0        // components remembered by useCache(true), 0: useCache() does nothing
+#endif
+
+#ifndef NEXTION_EZ_WAVE_CHANNELS
+#define NEXTION_EZ_WAVE_CHANNELS 0  // waveform channels that streamWave() can buffer, 0: it sends each value with add
+#endif
+
+#ifndef NEXTION_EZ_WAVE_SIZE
+#define NEXTION_EZ_WAVE_SIZE 32   // values buffered for each channel (max 255)
+#endif
+
+#ifndef NEXTION_EZ_WAVE_BLOCK
+#define NEXTION_EZ_WAVE_BLOCK 16  // streamWave() sends when this many values are waiting
+#endif
+
+#ifndef NEXTION_EZ_WINDOW
+#define NEXTION_EZ_WINDOW 0       // most commands that can wait for an answer with useFlowControl(true), 0: no flow control
+#endif
+
+#ifndef NEXTION_EZ_CMD_MAX
+#define NEXTION_EZ_CMD_MAX 16     // bytes of a custom command kept for readByte(), the rest are skipped (max 255)
+#endif
+
+#ifndef NEXTION_EZ_NATIVE_EVENTS
+#define NEXTION_EZ_NATIVE_EVENTS 0  // 1: touch, sleep and ready frames of Nextion go to cmdAvail() and onCommand() too
+#endif
+
+#ifndef NEXTION_EZ_BULK_SIZE
+#define NEXTION_EZ_BULK_SIZE 0    // bytes of the queue for commands sent with setPriority(NEX_PRIO_BULK), 0: sent at once
+#endif
+
+#ifndef NEXTION_EZ_RX_SIZE
+#define NEXTION_EZ_RX_SIZE 0      // receive ring of the library, filled by pump(). 0 reads the Serial directly
+#endif
+
+#ifndef NEXTION_EZ_PAGED
+#define NEXTION_EZ_PAGED 0        // components that can be given a page with onPage() or kept while Nextion sleeps
+#endif
+
+#ifndef NEXTION_EZ_PAGED_TEXT
+#define NEXTION_EZ_PAGED_TEXT 0   // longest text onPage() keeps for each of them, 0: texts are always sent
+#endif
+
+#ifndef NEXTION_EZ_SLEEP_NAME
+#define NEXTION_EZ_SLEEP_NAME 15  // longest plain name ("n0.val") a write keeps while Nextion sleeps (with NEXTION_EZ_PAGED)
+#endif
+
+#ifndef NEXTION_EZ_EVENTS
+#define NEXTION_EZ_EVENTS 4       // commands from Nextion kept until cmdAvail() takes them
+#endif
+
+#ifndef NEXTION_EZ_HANDLERS
+#define NEXTION_EZ_HANDLERS 8     // command groups that can have a function with onCommand()
+#endif
 
+#ifndef NEXTION_EZ_TASK
+ #if defined(ESP32)
+ #define NEXTION_EZ_TASK 1        // beginTask(): listen() runs in a task of its own, the functions can be called from any task
+ #else
+ #define NEXTION_EZ_TASK 0
+ #endif
+#endif
+
+#if NEXTION_EZ_TASK
+ #if defined(ESP32)
+ #include "freertos/FreeRTOS.h"
+ #include "freertos/task.h"
+ #include "freertos/semphr.h"
+ typedef SemaphoreHandle_t nexMutex;
+ #else
+ #include <atomic>                // a PC build (extras/host): a std::thread in place of the FreeRTOS task
+ #include <chrono>
+ #include <mutex>
+ #include <thread>
+ typedef std::recursive_mutex* nexMutex;
+ #endif
+#endif
+
+#ifndef NEXTION_EZ_STATS
+#define NEXTION_EZ_STATS 0        // 1 to count what goes over the link, see getStats(). 0 costs nothing
+#endif
+
+#ifndef NEXTION_EZ_TRACE
+#define NEXTION_EZ_TRACE 0        // 1 to record the bytes of the link with traceTo(), for nextionReplay. 0 costs nothing
+#endif
+
+  //------------------------------------------------------
+ // status passed to the request callbacks
+//--------------------------------------------------------
+#define NEX_OK      0             // the reply arrived and the value is valid
+#define NEX_TIMEOUT 1             // no reply arrived in time
+#define NEX_ERROR   2             // Nextion answered with an error code (wrong name, ...)
 
+  //------------------------------------------------------
+ // priorities of setPriority()
+//--------------------------------------------------------
+#define NEX_PRIO_HIGH 0           // sent at once, the default
+#define NEX_PRIO_BULK 1           // queued, sent by listen() when the Serial has room
+
+  //------------------------------------------------------
+ // modes of setWaveDecimation()
+//--------------------------------------------------------
+#define NEX_WAVE_MEAN   0         // the mean of the samples of each column
+#define NEX_WAVE_MINMAX 1         // the lowest and the highest sample of each column, two values
+
+typedef void (*nextionNumCallback)(uint8_t status, uint32_t value);
+typedef void (*nextionStrCallback)(uint8_t status, const char* text);
+typedef void (*nextionCmdCallback)(uint16_t id, uint8_t status);
+typedef void (*nextionSleepCallback)(bool asleep);
+typedef void (*nextionChunkCallback)(const char* part, uint8_t length);
+typedef void (*nextionCommandHandler)(uint8_t group, const uint8_t* data, uint8_t length);
+
+#if NEXTION_EZ_STATS
+  //------------------------------------------------------
+ // link statistics, returned by getStats()
+//--------------------------------------------------------
+struct nextionStats {
+  uint32_t txBytes;               // bytes written to the Serial
+  uint32_t rxBytes;               // bytes read by listen()
+  uint32_t commands;              // commands sent
+  uint32_t numReplies;            // 0x71 frames, replies of readNum() and requestNum()
+  uint32_t strReplies;            // 0x70 frames, replies of readStr() and requestStr()
+  uint32_t okFrames;              // 0x01 frames, with bkcmd=1 or 3
+  uint32_t errorFrames;           // error codes of Nextion, see getLastError()
+  uint32_t touchFrames;           // 0x65, 0x67 and 0x68 frames
+  uint32_t pageFrames;            // 0x66 frames and '#' 'P' commands
+  uint32_t customFrames;          // other '#' commands
+  uint32_t otherFrames;           // sleep, wake up, ready, upgrade and addt frames
+  uint32_t requestTimeouts;       // reads and requests that got no reply in time
+  uint32_t lateReplies;           // replies that came after the timeout of their get, dropped
+  uint32_t flowTimeouts;          // commands that got no answer with useFlowControl(true)
+  uint32_t droppedFrames;         // frames that were broken or stopped in the middle
+  uint32_t skippedBytes;          // bytes out of any frame, skipped looking for the next one
+  uint32_t listenMaxUs;           // the longest listen() call, in microseconds
+  uint32_t lostEvents;            // commands lost because the queue of cmdAvail() was full
+  uint32_t bulkFull;              // NEX_PRIO_BULK commands sent at once because their queue was full
+};
+
+typedef void (*nextionStatsCallback)(const nextionStats& stats);
+#endif
+
+  //------------------------------------------------------
+ // component handles, made once with NEX_COMPONENT()
+//--------------------------------------------------------
+struct nextionComponent {
+  const char* set;                // "n0.val=" stored in flash
+  const char* get;                // "get n0.val" stored in flash
+  uint8_t length;                 // characters of the name
+  uint32_t key;                   // hash of the name for useCache(), found by the compiler
+};
+
+constexpr uint32_t nexHash(const char* txt, uint32_t hash = 2166136261UL){  // FNV-1a, the same as the cache
+  return *txt == '\0' ? hash : nexHash(txt + 1, (hash ^ (uint8_t)*txt) * 16777619UL);
+}
+
+constexpr bool nexNameChar(char c){
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+         c == '.' || c == '_' || c == '[' || c == ']';
+}
+
+constexpr bool nexValidName(const char* name, uint8_t length = 0){  // letters, digits and . _ [ ] only
+  return *name == '\0' ? (length > 0 && length < 255) : (nexNameChar(*name) && nexValidName(name + 1, length + 1));
+}
+
+/* NEX_COMPONENT(handle, "name"): makes a handle for a component, with the "name=" and "get name"
+ * texts ready in flash, so writes only copy them and add the value.
+ * A name with a space, a quote or any wrong character does not compile.
+ * Write it outside of any function:  NEX_COMPONENT(speed, "n0.val");
+ * and use it like a name:            myNex.writeNum(speed, 100);  x = myNex.readNum(speed);
+ */
+#define NEX_COMPONENT(handle, name) \
+  static_assert(nexValidName(name), "not a valid Nextion component name: " name); \
+  static const char handle##_set[] PROGMEM = name "="; \
+  static const char handle##_get[] PROGMEM = "get " name; \
+  static const nextionComponent handle = {handle##_set, handle##_get, sizeof(name) - 1, nexHash(name)}
 
 /**************************************************************************/
 /** 
@@ -40,15 +230,51 @@ class nextion_ez {
    * initialization data: unsigned long baud = 9600 (default) if nothing written in the begin()
    * myObject.begin(115200); for baud rate 115200
    * 
+   * -- beginAuto(): instead of begin(), finds the baud rate of Nextion and moves both sides
+   * to the fastest rate allowed. myObject.beginAuto(115200); returns the baud rate in use, 0 if no Nextion
+   * 
+   * -- onPage(handle, page): writes to a component made with NEX_COMPONENT() are kept, not sent, while an other page
+   * is shown, and sent when its page is loaded. clearPages() forgets all of them
+   * 
+   * -- isAsleep(): true while Nextion sleeps (0x86 up to 0x87). Writes are not sent meanwhile, the newest value of
+   * each component is sent when it wakes up, lostWrites() counts the ones that could not be kept.
+   * setSleepCallback(function) calls void function(bool asleep) when it changes
+   * 
+   * -- pump(): moves the bytes that arrived from the Serial to the receive ring of the library (NEXTION_EZ_RX_SIZE),
+   * so they are not lost while the loop is busy. Call it from slow code, serialEvent() or a timer (not on an ESP32).
+   * rxHighWater() is the most bytes that were ever waiting, rxOverruns() the times the ring was full
+   * 
+   * -- setPriority(NEX_PRIO_BULK): the commands that follow wait in a queue and listen() sends them only when
+   * the Serial has room, so commands sent with NEX_PRIO_HIGH (the default) go first. pendingBulk() is the bytes waiting
+   * 
+   * -- getStats(): with NEXTION_EZ_STATS set to 1, the counters of the link (bytes, commands, frames of each
+   * kind, timeouts, skipped bytes, longest listen()). resetStats() sets them to 0 and
+   * setStatsReport(function, ms) calls void function(const nextionStats& stats) from listen() every ms milliseconds
+   * 
+   * -- traceTo(buffer, size) or traceTo(stream): with NEXTION_EZ_TRACE set to 1, records every byte sent and received,
+   * with the time, to a char array of yours (the newest records are kept) or to a Stream (an SD file, a second Serial).
+   * traceDump(stream) writes the records of the array, traceStop() ends the recording. nextionReplay plays them again
+   * 
+   * -- beginTask(): on an ESP32, instead of begin(). A task of the library calls listen() all the time, so the loop
+   * does not have to, and every function can be called from any task. lock() and unlock() keep a group of calls
+   * (like pushCmdArg() and sendCmd()) together. Callbacks and onCommand() functions run in the task of the library
+   * On a PC (extras/host, with NEXTION_EZ_TASK 1) the task is a std::thread, to test the same code with many threads
+   * 
+   * -- NEX_COMPONENT(handle, "n0.val"): a handle that writeNum(), writeStr(), readNum() and requestNum()
+   * take in place of the name, with the command texts made by the compiler (see above the class)
+   * 
    * -- nextion_ez(HardwareSerial& serial): The constructor of the class that has the parameter of the Serial we use
    * nextion_ez.myObject(Serial);  or Serial1, Serial2....
+   * Any other Stream can be used too (SoftwareSerial, USB Serial...), but then the sketch must
+   * start it with its own begin() before myObject.begin(), as the library cannot set its baud rate
    *
    * -- writeNum(String, unsigned int): for writing in components' numeric attribute
    * String = objectname.numericAttribute (example: "n0.val"  or "n0.bco".....etc)
    * unsigned int = value (example: 84)
    * Syntax: | myObject.writeNum("n0.val", 765);  |  or  | myObject.writeNum("n0.bco", 17531);       |
    *         | set the value of numeric n0 to 765 |      | set background color of n0 to 17531 (blue)|
-   * 
+   * The name can also be a char array or F("n0.val"), writeStr() and sendCmd() take them too.
+   * Those do not use the heap memory, better for values that are sent many times per second.
    * 
    * -- writeStr(String, String): for writing in components' text attributes
    * String No1 = objectname.textAttribute (example: "t0.txt"  or "b0.txt")
@@ -56,6 +282,11 @@ class nextion_ez {
    * Syntax: | myObject.writeStr("t0.txt", "Hello World");  |  or  | myObject.writeNum("b0.txt", "Button0"); |
    *         | set the value of textbox t0 to "Hello World" |      | set the text of button b0 to "Button0"  |
    * 
+   * -- writeInt(String, int32_t) and readInt(String): like writeNum() and readNum(), for signed values (-40 stays -40)
+   * 
+   * -- writeFixed(String, float, decimals): a float for an Xfloat component, decimals = its vvs1.
+   * Syntax: | myObject.writeFixed("x0.val", 23.47, 1); |  sends 235, shown as 23.5
+   * 
    * -- listen(): It uses a custom protocol to identify commands from Nextion Touch Events
    * For advanced users: You can modify the custom protocol to add new group commands.
    * More info on custom protocol: https://www.seithan.com/  and on the documentation of the library
@@ -71,39 +302,168 @@ class nextion_ez {
    * -- readStr(String): We use it to read the value of every components' text attribute from Nextion (txt etc...)
    * String = objectname.textAttribute (example: "t0.txt", "va0.txt", "b0.txt"...etc)
    * Syntax: String x = myObject.readStr("t0.txt"); // Store to x the value of text box t0
+   * readStr("t0.txt", buffer, sizeof(buffer)) copies the text to a char array of yours and returns its length (-1 on error),
+   * readStr("t0.txt", function) gives it in parts to void function(const char* part, uint8_t length). Both never use the heap
+   *
+   * -- beginBatch() and flush(): the commands between them are kept in the transmit buffer
+   * of the library and are sent together, instead of one by one
    *
-   * -- readByte() : We read the next byte from the Serial
+   * -- streamWave(id, channel, value): like addWave(), but the values are buffered and sent
+   * in blocks with the addt command, about 7 times less bytes. listen() does the sending
+   *
+   * -- setWaveDecimation(id, channel, samples, mode, inputMax) and sampleWave(id, channel, value): for signals
+   * sampled faster than the waveform can draw. Every "samples" samples make one column, their mean (NEX_WAVE_MEAN)
+   * or their lowest and highest (NEX_WAVE_MINMAX), scaled from 0..inputMax to 0..255 and sent with streamWave()
+   *
+   * -- useFlowControl(bool): with true, Nextion answers every command (bkcmd=3) and the library
+   * never sends more than Nextion can keep. setCommandCallback() tells the result of each command
+   *
+   * -- useCache(bool): with true, writeNum() and writeStr() do not send again a value that
+   * Nextion already shows. clearCache() forgets the values, so they are sent again
+   *
+   * -- readNums(names, values, status, count, timeout): reads many numeric attributes at once,
+   * all the "get" commands are sent together and the replies fill the values array in order
+   * Syntax: | myObject.readNums(names, values, status, 12, 1000); |
+   *
+   * -- requestNum(String, callback): the same as readNum() but it does NOT wait for the reply
+   * It sends the "get" command and returns at once. When the reply arrives, listen() calls the callback
+   * with the status (NEX_OK, NEX_TIMEOUT or NEX_ERROR) and the value
+   * Syntax: | myObject.requestNum("n0.val", gotNumber); |  where | void gotNumber(uint8_t status, uint32_t value) |
+   *
+   * -- requestStr(String, callback): the same as readStr() but it does NOT wait for the reply
+   * Syntax: | myObject.requestStr("t0.txt", gotText); |  where | void gotText(uint8_t status, const char* text) |
+   *
+   * -- readByte() : We read the next byte of the last command found by listen()
    * Main purpose and usage is for the custom commands read
    * Where we need to read bytes from Serial inside user code
+   * With NEXTION_EZ_NATIVE_EVENTS 1, touch (0x65, 0x67, 0x68), sleep (0x86), wake up (0x87) and ready (0x88)
+   * frames of Nextion are also given as commands: getCmd() returns the code and readByte() the data bytes
+   * After the bytes of the command it returns -1, it never reads the Serial.
+   * Only NEXTION_EZ_CMD_MAX bytes are kept, getCmdLen() returns how many. Set it to 255 to keep every command whole
    * Syntax: | myObject.readByte(); |
+   *
+   * -- cmdAvail(): true if a command has arrived, then getCmd(), getCmdLen() and readByte() are about it.
+   * Up to NEXTION_EZ_EVENTS commands wait in a queue, so call it until it returns false
+   *
+   * -- onCommand(group, function): listen() calls void function(uint8_t group, const uint8_t* data, uint8_t length)
+   * for every command of this group, they do not go to cmdAvail()
    */
    
 
 	public:
     nextion_ez(HardwareSerial& serial);
+    nextion_ez(Stream& serial);
+#if NEXTION_EZ_TASK && !defined(ESP32)
+    ~nextion_ez();                  // the thread of beginTask() must end before the object
+#endif
     void begin(unsigned long baud = 9600);
+    unsigned long beginAuto(unsigned long maxBaud = 115200);
+#if NEXTION_EZ_TASK
+    bool beginTask(unsigned long baud = 9600, int core = 0);
+    void endTask();
+    void lock();
+    void unlock();
+#endif
     
     void listen(void);
+    void pump(void);
+    int rxHighWater();
+    uint32_t rxOverruns();
     
     bool cmdAvail();
+    bool onCommand(uint8_t group, nextionCommandHandler);
+    int pendingEvents();
     int getCmd();
     int getCmdLen();
     int readByte();
+    int getLastError();
     
     int getCurrentPage();
     int getLastPage();
-    uint32_t readNum(String);
-    String readStr(String);
+    uint32_t readNum(const String&);
+    uint32_t readNum(const char*);
+    uint32_t readNum(const nextionComponent&);
+    int32_t readInt(const String&);
+    int32_t readInt(const char*);
+    int32_t readInt(const nextionComponent&);
+    String readStr(const String&);
+    int readStr(const char*, char* buffer, size_t size);
+    uint8_t readStr(const char*, nextionChunkCallback);
+    uint8_t readNums(const char* const names[], uint32_t values[], uint8_t status[], uint8_t count, unsigned long timeout = 1000);
+    bool requestNum(const String&, nextionNumCallback);
+    bool requestNum(const char*, nextionNumCallback);
+    bool requestNum(const nextionComponent&, nextionNumCallback);
+    bool requestStr(const String&, nextionStrCallback);
+    bool requestStr(const char*, nextionStrCallback);
+    int pendingRequests();
+    void setRequestTimeout(unsigned long timeout);
     
     void setCurrentPage(int page);
     void setLastPage(int page);
-    void writeNum(String, uint32_t);
+    void writeNum(const String&, uint32_t);
+    void writeNum(const char*, uint32_t);
+    void writeNum(const __FlashStringHelper*, uint32_t);
+    void writeNum(const nextionComponent&, uint32_t);
+    void writeInt(const String&, int32_t);
+    void writeInt(const char*, int32_t);
+    void writeInt(const __FlashStringHelper*, int32_t);
+    void writeInt(const nextionComponent&, int32_t);
+    void writeFixed(const String&, float, uint8_t decimals);
+    void writeFixed(const char*, float, uint8_t decimals);
+    void writeFixed(const __FlashStringHelper*, float, uint8_t decimals);
+    void writeFixed(const nextionComponent&, float, uint8_t decimals);
     void writeByte(uint8_t val);
-    void writeStr(String, String);
+    void writeStr(const String&, const String&);
+    void writeStr(const char*, const char*);
+    void writeStr(const char*, const char*, size_t length);
+    void writeStr(const __FlashStringHelper*, const char*);
+    void writeStr(const __FlashStringHelper*, const __FlashStringHelper*);
+    void writeStr(const nextionComponent&, const char*);
     
     void pushCmdArg(uint32_t val);
-    void sendCmd(String);
+    void sendCmd(const String&);
+    void sendCmd(const char*);
+    void sendCmd(const char*, size_t length);
+    void sendCmd(const __FlashStringHelper*);
     void addWave(uint8_t id, uint8_t channel, uint8_t val);
+    bool streamWave(uint8_t id, uint8_t channel, uint8_t val);
+    bool setWaveDecimation(uint8_t id, uint8_t channel, uint16_t samples, uint8_t mode = NEX_WAVE_MINMAX, uint16_t inputMax = 255);
+    bool sampleWave(uint8_t id, uint8_t channel, uint16_t val);
+    void sendWave();
+    
+    void beginBatch();
+    void flush();
+    
+    void setPriority(uint8_t priority);
+    int pendingBulk();
+    
+    void useFlowControl(bool on);
+    void setFlowWindow(uint8_t commands, uint16_t bytes);
+    void setCommandCallback(nextionCmdCallback);
+    uint16_t lastCommandId();
+    int pendingCommands();
+    
+    bool onPage(const nextionComponent&, uint8_t page);
+    void clearPages();
+    bool isAsleep();
+    uint16_t lostWrites();
+    void setSleepCallback(nextionSleepCallback);
+    
+    void useCache(bool on);
+    void clearCache();
+    void clearCache(const char*);
+    
+#if NEXTION_EZ_STATS
+    const nextionStats& getStats();
+    void resetStats();
+    void setStatsReport(nextionStatsCallback, unsigned long interval);
+#endif
+#if NEXTION_EZ_TRACE
+    void traceTo(uint8_t* buffer, uint16_t size);
+    void traceTo(Stream& out);
+    void traceStop();
+    void traceDump(Stream& out);
+#endif
     
     
       //--------------------------------------- 
@@ -115,8 +475,10 @@ class nextion_ez {
      * printh 23 02 50 xx , where xx the id of the page in hex 
      * (example: for page0, we write: printh 23 02 50 00 , for page9: printh23 02 50 09, for page10: printh 23 02 50 0A) 
      * Use can call it by writing in the .ino file code:  variable = myObject.currentPageId;
+     * Until the first page command (or sendme reply) arrives, it is 0, the page Nextion starts with.
+     * setCurrentPage() can tell an other one, even before begin()
      * 
-     * lastCurrentPageId: stores the value of the previous page shown on Nextion
+     * lastCurrentPageId: stores the value of the previous page shown on Nextion, 0 before the first change
      * No need to write anything in Preinitialize Event on Nextion
      * You can call it by writing in the .ino file code:  variable = myObject.lastCurrentPageId;
      *
@@ -131,21 +493,226 @@ class nextion_ez {
 	 // library-accessible "private" interface
     //-----------------------------------------
 	private:
-    HardwareSerial* _serial;
-	void readCommand(void);
-    //void callTriggerFunction(void);
+    Stream* _serial;                // every read and write goes here
+#if NEXTION_EZ_TASK
+    nexMutex _mutex;                // taken by every public function, once beginTask() has made it
+ #if defined(ESP32)
+    TaskHandle_t _task;
+ #else
+    std::thread* _task;
+    std::atomic<bool> _taskRun;     // false tells the thread to end
+ #endif
+    static void taskLoop(void* object);
+#endif
+    HardwareSerial* _hwSerial;      // the same Serial when begin() can set its baud rate, otherwise NULL
+    void setBaud(unsigned long);
     
-      //----------------------------------------------
-     // for function writeNum() (write to numeric attribute)
-    //------------------------------------------------
-	String _component;     // Also used in writeStr()
-    uint32_t _numVal;
+    enum { NEX_PAGED_NONE, NEX_PAGED_NUM, NEX_PAGED_INT, NEX_PAGED_TEXT };  // the kind of value kept by onPage()
+    enum { NEX_PAGE_ANY = 0xFF };   // the page of an entry kept only while Nextion sleeps
+    struct pagedEntry {
+      const nextionComponent* comp;   // NULL for a plain name, kept in name
+      uint32_t key;
+      uint8_t page;
+      uint8_t state;
+      uint32_t value;
+#if NEXTION_EZ_PAGED_TEXT > 0
+      char text[NEXTION_EZ_PAGED_TEXT + 1];
+#endif
+#if NEXTION_EZ_SLEEP_NAME > 0
+      char name[NEXTION_EZ_SLEEP_NAME + 1];
+#endif
+    };
+#if NEXTION_EZ_PAGED > 0
+    pagedEntry _paged[NEXTION_EZ_PAGED];
+#endif
+    uint8_t _pagedCount;
+    pagedEntry* findPaged(uint32_t key);
+    pagedEntry* holdEntry(uint32_t key, const nextionComponent* comp, const char* name, bool nameInFlash);
+    bool deferNum(uint32_t key, const nextionComponent* comp, const char* name, bool nameInFlash,
+                  uint32_t value, uint8_t state = NEX_PAGED_NUM);
+    bool deferStr(uint32_t key, const nextionComponent* comp, const char* name, bool nameInFlash,
+                  const char* txt, size_t length, bool inFlash);
+    bool lostWrite(uint32_t key);
+    void sendPaged(void);
+    void sendPagedName(pagedEntry* entry);
     
-      //--------------------------------------------
-     // for function writeStr() (write to text attribute)
-    //----------------------------------------------
-    String _strVal;
+    bool _asleep;                   // between 0x86 and 0x87 of Nextion
+    uint16_t _lostWrites;           // writes dropped while asleep, for lostWrites()
+    nextionSleepCallback _sleepCallback;
+    void setAsleep(bool asleep);
+    int rxAvailable(void);
+    int rxRead(void);
+    void rxClear(void);
     
+#if NEXTION_EZ_RX_SIZE > 0
+    uint8_t _rxBuf[NEXTION_EZ_RX_SIZE];  // filled by pump(), maybe from an interrupt, and read by listen()
+    volatile uint16_t _rxHead;
+    volatile uint16_t _rxTail;
+    volatile bool _pumping;         // a pump() is running, one from an interrupt must not start
+    uint16_t rxCount(void);
+#endif
+    uint16_t _rxHighWater;
+    uint32_t _rxOverruns;
+    
+#if NEXTION_EZ_STATS
+    nextionStats _stats;
+    nextionStatsCallback _statsCallback;
+    unsigned long _statsInterval;
+    unsigned long _statsTime;
+    void countFrame(void);
+#endif
+#if NEXTION_EZ_TRACE
+    enum { NEX_TRACE_CHUNK = 32 };  // most bytes in one record of the trace
+    bool _traceOn;
+    Stream* _traceOut;              // traceTo(stream), or NULL
+    uint8_t* _traceRing;            // traceTo(buffer, size), whole records, the oldest are dropped
+    uint16_t _traceSize;
+    uint16_t _traceTail;
+    uint16_t _traceUsed;
+    uint8_t _traceRec[3 + NEX_TRACE_CHUNK];  // the record being filled, <sent|length> <ms low> <ms high> <bytes>
+    uint8_t _traceLen;
+    unsigned long _traceTime;       // millis() of the last record
+    void traceByte(bool sent, uint8_t c);
+    void traceEnd(void);
+    void tracePut(const uint8_t* data, uint16_t length);
+#endif
+	void readCommand(void);
+    void sendCmdArgs(void);
+    void txSend(void);
+    void txWrite(const uint8_t*, size_t length);
+    void txChar(uint8_t);
+    void txText(const char*);
+    void txText(const char*, size_t length);
+    void txText(const __FlashStringHelper*);
+    void txFlash(const char*, uint8_t length);
+    void txNumber(uint32_t);
+    void txSigned(int32_t);
+    enum { NEX_ACK_CMD, NEX_ACK_GET, NEX_ACK_NONE };  // the answer a command gets with bkcmd=3
+    void txEnd(uint8_t ack = NEX_ACK_CMD);
+    bool bulkAdd(uint8_t ack, uint32_t key);
+    void bulkForget(uint32_t key);
+    void bulkCompact(void);
+    void sendBulk(void);
+    uint8_t bulkByte(uint16_t offset);
+    uint32_t bulkKey(uint16_t offset);
+    bool flowFull(uint16_t bytes);
+    void flowWait(void);
+    void flowAdd(uint16_t bytes, bool isGet, uint32_t key);
+    void flowDone(uint8_t status);
+    void startWave(void);
+    void sendWaveData(void);
+    bool cacheSame(uint32_t key, uint32_t value);
+    void cacheKeep(uint32_t key, uint8_t state);
+    void cacheSent(uint8_t state, uint32_t key);
+    void cacheForget(uint32_t key);
+    uint32_t hashText(const char*);
+    uint32_t hashText(const char*, size_t length);
+    uint32_t hashText(const __FlashStringHelper*);
+    bool addRequest(uint8_t, nextionNumCallback, nextionStrCallback, uint8_t kind);
+    bool sendRequest(const char*, uint8_t, nextionNumCallback, nextionStrCallback, uint8_t kind);
+    uint32_t waitNum(void);
+    void finishRequest(uint8_t status);
+    bool probe(void);
+    void parseByte(uint8_t);
+    void readReply(void);
+    //void callTriggerFunction(void);
+    
+	  //---------------------------------------
+	 // transmit buffer, for all the write functions
+    //-----------------------------------------
+    uint8_t _txBuf[NEXTION_EZ_TX_SIZE];
+    uint8_t _txLen;
+    bool _txHold;                   // true between beginBatch() and flush()
+    uint16_t _txCmdBytes;           // length of the command being built
+    uint32_t _txKey;                // hash of the component being written, 0 for other commands
+    uint8_t _txPriority;
+#if NEXTION_EZ_BULK_SIZE > 0
+    uint8_t _bulk[NEXTION_EZ_BULK_SIZE];  // ring of <ack> <len> <key 4 bytes> <command> entries
+#endif
+    uint16_t _bulkTail;
+    uint16_t _bulkUsed;
+    int _txRoomMax;                 // the most free space ever seen in the Serial transmit buffer
+
+	  //---------------------------------------
+	 // for function useFlowControl()
+    //-----------------------------------------
+    struct flowEntry {
+      uint16_t id;
+      uint16_t bytes;
+      bool isGet;
+      unsigned long sent;
+      uint32_t key;                 // the component of a write, its cached value is forgotten if it fails
+    };
+#if NEXTION_EZ_WINDOW > 0
+    flowEntry _flow[NEXTION_EZ_WINDOW];  // the commands waiting for an answer, oldest first
+#endif
+    uint8_t _flowHead;
+    uint8_t _flowTail;
+    uint8_t _flowCount;
+    uint16_t _flowBytes;
+    uint8_t _flowMaxCmds;
+    uint16_t _flowMaxBytes;
+    bool _flowOn;
+    bool _flowWaiting;
+    uint8_t _flowUnsent;            // counted commands still in _txBuf, held by beginBatch()
+    uint16_t _cmdId;
+    nextionCmdCallback _cmdCallback;
+
+	  //---------------------------------------
+	 // for function useCache(), the last values sent
+    //-----------------------------------------
+    enum { NEX_CACHE_FREE, NEX_CACHE_HELD, NEX_CACHE_BULK, NEX_CACHE_SENT };  // where the value of a cacheEntry is
+    struct cacheEntry {
+      uint32_t key;                 // hash of the component name
+      uint32_t value;               // the number, or the hash of the text
+      uint8_t state;                // in _txBuf, in the bulk queue or sent
+    };
+#if NEXTION_EZ_CACHE > 0
+    cacheEntry _cache[NEXTION_EZ_CACHE];
+#endif
+    uint8_t _cacheNext;
+    bool _cacheOn;
+    bool _cacheHeld;                // an entry is NEX_CACHE_HELD, txSend() makes it NEX_CACHE_SENT
+    bool _txCached;                 // the write being built goes to the cache with _txValue, see txEnd()
+    uint32_t _txValue;
+
+	  //---------------------------------------
+	 // for function streamWave()
+    //-----------------------------------------
+    struct waveChannel {
+      bool used;
+      uint8_t id;
+      uint8_t channel;
+      uint8_t head;                 // ring buffer of the values
+      uint8_t count;
+      uint8_t data[NEXTION_EZ_WAVE_SIZE];
+      uint16_t every;               // samples for each column of setWaveDecimation(), 0 for none
+      uint16_t inputMax;
+      uint8_t mode;
+      uint16_t seen;                // samples of the column so far
+      uint16_t low;
+      uint16_t high;
+      uint32_t sum;
+      bool lowFirst;                // the lowest sample came before the highest
+      uint8_t fails;                // addt that failed in a row, each one doubles the wait before the next
+      unsigned long failTime;
+    };
+#if NEXTION_EZ_WAVE_CHANNELS > 0
+    waveChannel _wave[NEXTION_EZ_WAVE_CHANNELS];
+#endif
+    waveChannel* findWave(uint8_t id, uint8_t channel, bool create);
+    void wavePut(waveChannel* wave, uint8_t val);
+    uint8_t waveScale(waveChannel* wave, uint32_t val);
+    void waveFailed(void);
+    enum { NEX_WAVE_IDLE, NEX_WAVE_READY, NEX_WAVE_DONE };
+    uint8_t _waveState;             // READY: addt sent, waiting for 0xFE. DONE: data sent, waiting for 0xFD
+    uint8_t _waveSlot;
+    uint8_t _waveCount;
+    uint8_t _waveNext;
+    bool _waveFlush;
+    unsigned long _waveTime;
+    bool _txWaiting;                // txSend() waits for the data of a block, no new block may start meanwhile
+
 	  //---------------------------------------
 	 // for function sendCmd()
     //-----------------------------------------
@@ -156,22 +723,36 @@ class nextion_ez {
 	  //---------------------------------------
 	 // for function readNum()
     //-----------------------------------------
-	String _comp;
-	uint8_t _numericBuffer[4];
 	uint32_t _numberValue;
     
       //---------------------------------------
 	 // for General functions  
     //-----------------------------------------
-    char _start_char;
     unsigned long _tmr1;
 
-    bool _cmdFound;
     uint8_t _cmd1;
     uint8_t _len;
-    bool _cmdAvail;
+    uint8_t _rxCmd[NEXTION_EZ_CMD_MAX];   // the command being received
+    uint8_t _rxCmdCount;
+    struct nexEvent {
+      uint8_t count;                // bytes kept of the command, with the group
+      uint8_t data[NEXTION_EZ_CMD_MAX];
+    };
+    nexEvent _events[NEXTION_EZ_EVENTS];  // ring of commands for cmdAvail()
+    uint8_t _eventTail;
+    uint8_t _eventCount;
+    struct handlerEntry {
+      uint8_t group;
+      nextionCommandHandler handler;
+    };
+    handlerEntry _handlers[NEXTION_EZ_HANDLERS];
+    uint8_t _handlerCount;
+    void addEvent(uint8_t count);
     byte _cmdGroup;
     byte _cmdLength;
+    uint8_t _cmdBuf[NEXTION_EZ_CMD_MAX];  // the bytes of the last command, <cmd> <id> <id2>...
+    uint8_t _cmdCount;
+    uint8_t _cmdRead;                   // next byte for readByte()
 
     int _currentPageId;  
     int _lastCurrentPageId;
@@ -180,7 +761,95 @@ class nextion_ez {
 		 // for function readStr()
     //-----------------------------------------  
     String _readString;
+    char* _strBuf;                  // the char array of readStr(name, buffer, size)
+    size_t _strSize;
+    size_t _strLen;                 // length of the text received so far
+    nextionChunkCallback _chunkCallback;
+    uint8_t waitStr(const char*, uint8_t kind);
+    void takeText(uint8_t);
+    
+      //---------------------------------------
+		 // for functions requestNum() and requestStr()
+    //-----------------------------------------
+    enum { NEX_REQ_CALLBACK, NEX_REQ_WAIT, NEX_REQ_BATCH,   // callback, readNum()/readStr(), readNums()
+           NEX_REQ_BUFFER, NEX_REQ_CHUNKS };                // readStr() to a char array or to a callback
+    struct request {
+      uint8_t code;                 // the reply we expect, 0x71 for numbers or 0x70 for text
+      uint8_t kind;                 // who gets the reply, NEX_REQ_...
+      nextionNumCallback numCallback;
+      nextionStrCallback strCallback;
+      unsigned long sent;           // millis() when the "get" was sent
+      uint16_t writes;              // _writeCount when it was sent
+    };
+    request _requests[NEXTION_EZ_REQUESTS];
+    uint8_t _reqHead;
+    uint8_t _reqTail;
+    uint8_t _reqCount;
+    unsigned long _reqTimeout;
+    bool _syncDone;                 // readNum() and readStr() wait for this
+    uint8_t _syncStatus;
+    uint32_t* _batchValues;         // for readNums()
+    uint8_t* _batchStatus;
+    uint8_t _batchDone;
+    uint8_t _batchGood;             // the values read with NEX_OK
+    uint16_t _writeCount;           // commands other than "get" sent, their errors come before the reply of a later get
+    uint16_t _writesAnswered;       // the _writeCount of the last get that got its reply, those are all answered
+    uint8_t _lateReplies;           // gets that timed out, their replies may still come and are dropped
+    bool _lateDropped;              // a late reply was dropped since the last good one, it may have been of a newer get
+
+      //---------------------------------------
+		 // for the frame parser of listen()
+    //-----------------------------------------
+    enum { NEX_RX_IDLE, NEX_RX_LEN, NEX_RX_CMD, NEX_RX_NATIVE };
+    uint8_t _rxState;
+    unsigned long _frameTime;       // millis() of the last byte, to drop frames that never finish
+    uint8_t _frameCode;             // Nextion return code of the frame being received
+    uint8_t _frameLen;              // data bytes expected, or NEX_LEN_VARIABLE
+    uint8_t _frameCount;
+    uint8_t _frameEnd;              // counts the 0xFF 0xFF 0xFF at the end of the frame
+    uint8_t _frameBuf[NEXTION_EZ_STR_MAX + 1];
+    uint8_t _lastError;
+    bool _gotPage;                  // a sendme reply arrived, for beginAuto()
+    
+};
+
+  //------------------------------------------------------
+ // plays a trace of traceTo() again, as the Serial of a nextion_ez
+//--------------------------------------------------------
+/* nextionReplay replay(trace, sizeof(trace), 10);   the bytes of a trace, 10 times faster than they came (0: at once)
+ * nextion_ez myNex(replay);                         listen() gets the received bytes of the trace at their time
+ * A record comes only after the library has sent what was sent before it, so replies follow their "get".
+ * replay.done() is true when all of them have been read. The bytes the library sends are checked against
+ * the sent bytes of the trace, txMismatches() counts the ones that differ.
+ * It does not need NEXTION_EZ_TRACE and also runs on a PC (see "Using the library on a PC")
+ */
+class nextionReplay : public Stream {
+  public:
+    nextionReplay(const uint8_t* trace, size_t length, uint8_t speed = 1);
+    int available();
+    int read();
+    int peek();
+    size_t write(uint8_t);
+    using Print::write;
+    bool done();
+    uint32_t txMismatches();
     
+  private:
+    const uint8_t* _trace;
+    size_t _length;
+    uint8_t _speed;
+    bool _started;
+    unsigned long _start;           // millis() of the first available() or read()
+    uint32_t _due;                  // ms from the start of the trace to the record at _rxPos
+    size_t _rxPos;                  // next received byte of the trace
+    uint8_t _rxLeft;                // bytes left in its record
+    size_t _txPos;                  // next sent byte of the trace
+    uint8_t _txLeft;
+    uint32_t _sent;                 // bytes the library has sent
+    uint32_t _sentBefore;           // bytes sent before the record at _rxPos, in the trace
+    uint32_t _mismatches;
+    void nextRx(void);
+    void nextTx(void);
 };
 
 #endif